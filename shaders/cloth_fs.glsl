@@ -9,6 +9,14 @@ struct PointLight {
     float intensity;
 };
 
+// per-frame data shared by every program, mirrored by FrameData in Renderer.h
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    PointLight pointLights[NUM_POINT_LIGHTS];
+};
+
 struct Material {
     float shininess;
 };
@@ -20,7 +28,6 @@ in VS_OUT {
     vec3 WorldViewPos;
 } fs_in;
 
-uniform PointLight pointLights[NUM_POINT_LIGHTS];
 uniform Material material;
 
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
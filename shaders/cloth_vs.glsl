@@ -9,17 +9,35 @@ out VS_OUT {
     vec3 WorldViewPos;
 } vs_out;
 
+#define NUM_POINT_LIGHTS 1
+
+struct PointLight {
+    vec3 position;
+    vec3 color;
+    float attenuation;
+    float intensity;
+};
+
+// per-frame data shared by every program, mirrored by FrameData in Renderer.h
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    PointLight pointLights[NUM_POINT_LIGHTS];
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec3 viewPos;
+// compact vertices are normalized against the bounding box, full float ones use offset 0 and scale 1
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
 
 void main() {
     mat3 normalMatrix = transpose(inverse(mat3(model)));
+    vec3 position = positionOffset + aPos * positionScale;
 
-    vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
+    vs_out.FragPos = vec3(model * vec4(position, 1.0));
     vs_out.Normal = normalMatrix * aNormal;
-    vs_out.WorldViewPos = vec3(model * vec4(viewPos, 1.0));
+    vs_out.WorldViewPos = vec3(model * vec4(viewPos.xyz, 1.0));
 
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * model * vec4(position, 1.0);
 }
\ No newline at end of file
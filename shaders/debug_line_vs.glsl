@@ -0,0 +1,29 @@
+#version 330 core
+
+// per instance, one constraint
+layout (location = 0) in uvec2 aParticles;
+layout (location = 1) in float aRestDistance;
+out vec3 aFragColor;
+
+// leading members of the per-frame block, mirrored by FrameData in Renderer.h
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+uniform mat4 model;
+// particle positions of this frame's ring section
+uniform samplerBuffer particles;
+uniform int particleBase;
+uniform float strainScale;
+
+void main() {
+    vec3 p1 = texelFetch(particles, particleBase + int(aParticles.x)).xyz;
+    vec3 p2 = texelFetch(particles, particleBase + int(aParticles.y)).xyz;
+    float strain = (distance(p1, p2) - aRestDistance) / aRestDistance;
+    float t = clamp(strain / strainScale, -1.0, 1.0);
+    // compressed blue, at rest green, stretched red
+    aFragColor = t < 0.0 ? mix(vec3(0.0, 1.0, 0.0), vec3(0.0, 0.3, 1.0), -t) : mix(vec3(0.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), t);
+    gl_Position = projection * view * model * vec4(gl_VertexID == 0 ? p1 : p2, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#version 330 core
+
+out vec3 aFragColor;
+
+// leading members of the per-frame block, mirrored by FrameData in Renderer.h
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+uniform mat4 model;
+// xyz position, w distance moved in the last step or -1 for pinned particles
+uniform samplerBuffer particles;
+uniform int particleBase;
+uniform float speedScale;
+
+void main() {
+    vec4 particle = texelFetch(particles, particleBase + gl_InstanceID);
+    float t = clamp(particle.w / speedScale, 0.0, 1.0);
+    aFragColor = particle.w < 0.0 ? vec3(1.0, 0.0, 1.0) : mix(vec3(0.2, 0.2, 1.0), vec3(1.0, 1.0, 0.0), t);
+    gl_Position = projection * view * model * vec4(particle.xyz, 1.0);
+}
\ No newline at end of file
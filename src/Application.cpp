@@ -1,36 +1,111 @@
 #include "Application.h"
 #include "utils.h"
 #include "Cloth.h"
+#include "ClothMesh.h"
+#include "DebugOverlay.h"
+#include "DistributedCloth.h"
+#include "FrameRecorder.h"
+#include "Mesh.h"
+#include "OffscreenContext.h"
+#include "TextRenderer.h"
+#include "WindField.h"
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <chrono>
+#include <cstdio>
 #include <utility>
 
+namespace {
+double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// exponential moving average, a single slow frame shouldn't make the HUD jump
+void smooth(float& average, double sample) {
+    average += ((float)sample - average) * 0.1f;
+}
+}
+
 Application::Application(std::string title, int w, int h) : app_title{std::move(title)}, window_width{w}, window_height{h} {
 
 }
 
 Application::~Application() {
+    if (recorder) {
+        delete recorder;
+        recorder = nullptr;
+    }
     glDeleteVertexArrays(1, &sphere_vao);
     glDeleteBuffers(1, &sphere_vbo_position);
     glDeleteBuffers(1, &sphere_vbo_normal);
     glDeleteBuffers(1, &sphere_ibo);
-    glDeleteBuffers(1, &axis_line_vao);
+    glDeleteVertexArrays(1, &axis_line_vao);
     glDeleteBuffers(1, &axis_line_vbo);
-    glDeleteBuffers(1, &sphere_vao2);
+    glDeleteVertexArrays(1, &sphere_vao2);
     glDeleteBuffers(1, &sphere_vbo_position2);
-    glDeleteBuffers(1, &grid_vao);
+    glDeleteBuffers(1, &sphere_vbo_normal2);
+    glDeleteBuffers(1, &sphere_ibo2);
+    glDeleteVertexArrays(1, &grid_vao);
     glDeleteBuffers(1, &grid_vbo);
     glDeleteBuffers(1, &grid_ibo);
-    glDeleteProgram(cloth_shader);
-    glDeleteProgram(axis_shader);
-    glDeleteProgram(grid_shader);
+    glDeleteProgram(cloth_shader.id);
+    glDeleteProgram(axis_shader.id);
+    glDeleteProgram(grid_shader.id);
+    if (renderer) {
+        delete renderer;
+        renderer = nullptr;
+    }
     if (cloth) {
         delete cloth;
         cloth = nullptr;
     }
+    if (distributed_cloth) {
+        delete distributed_cloth;
+        distributed_cloth = nullptr;
+    }
+    if (distributed_cloth_mesh) {
+        delete distributed_cloth_mesh;
+        distributed_cloth_mesh = nullptr;
+    }
+    if (wind_field) {
+        delete wind_field;
+        wind_field = nullptr;
+    }
+    if (debug_overlay) {
+        delete debug_overlay;
+        debug_overlay = nullptr;
+    }
+    if (text_renderer) {
+        delete text_renderer;
+        text_renderer = nullptr;
+    }
+    if (mesh_cache) {
+        delete mesh_cache;
+        mesh_cache = nullptr;
+    }
+    if (offscreen) {
+        delete offscreen;
+        offscreen = nullptr;
+    }
+}
+
+void Application::set_cloth_size(int w, int h) {
+    // three particles are pinned at each top corner and the coarsest LOD lattice needs a few cells
+    cloth_width = glm::max(w, 8);
+    cloth_height = glm::max(h, 8);
+}
+
+void Application::set_cloth_domain_count(int count) {
+    cloth_domain_count = glm::max(count, 0);
+}
+
+void Application::set_hud_font(const std::string& path) {
+    hud_font = path;
 }
 
 bool Application::initApp() {
+    if (!start_distributed_cloth())
+        return false;
     if (!glfwInit()) {
         error("glfw init error");
         return false;
@@ -63,57 +138,59 @@ bool Application::initApp() {
     }
 
     glEnable(GL_DEPTH_TEST);
-    return init();
+    return true;
 }
 
-bool Application::init() {
-    cloth_shader = load_shader_from_file("../shaders/cloth_vs.glsl", "../shaders/cloth_fs.glsl");
-    if (!cloth_shader)
+bool Application::initOffscreen(const std::string& output_dir, int frame_count) {
+    if (!FrameRecorder::prepare_directory(output_dir))
         return false;
-    axis_shader = load_shader_from_file("../shaders/axis_vs.glsl", "../shaders/axis_fs.glsl");
-    if (!axis_shader)
+    if (!start_distributed_cloth())
         return false;
-    grid_shader = load_shader_from_file("../shaders/grid_vs.glsl", "../shaders/grid_fs.glsl");
-    if (!grid_shader)
+    offscreen = new OffscreenContext();
+    if (!offscreen->create(window_width, window_height)) {
+        error("offscreen context init error");
         return false;
+    }
 
-    const auto& [positions, normals, indices] = generate_ico_sphere(3);
-    sphere_draw_call_count = indices.size();
-
-    glGenVertexArrays(1, &sphere_vao);
-    glBindVertexArray(sphere_vao);
-
-    glGenBuffers(1, &sphere_vbo_position);
-    glBindBuffer(GL_ARRAY_BUFFER, sphere_vbo_position);
-    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), &(positions.front()), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
-
-    glGenBuffers(1, &sphere_vbo_normal);
-    glBindBuffer(GL_ARRAY_BUFFER, sphere_vbo_normal);
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), &(normals.front()), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
-
-    glGenBuffers(1, &sphere_ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphere_ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &(indices.front()), GL_STATIC_DRAW);
+    // timings differ run to run, recorded frames stay reproducible without them
+    show_hud = false;
+    if (!init()) {
+        error("init failed");
+        return false;
+    }
 
-    glBindVertexArray(NULL);
+    glEnable(GL_DEPTH_TEST);
+    glPolygonMode(GL_FRONT_AND_BACK, is_wireframe ? GL_LINE : GL_FILL);
+    recorder = new FrameRecorder(window_width, window_height, output_dir, 0);
+    offscreen_frame_count = frame_count;
+    return true;
+}
 
-    const auto& positions2 = generate_uv_sphere(sphere_radius, 20, 20);
-    sphere_draw_call_count2 = positions2.size();
+bool Application::init() {
+    renderer = new Renderer("shader_cache");
+    if (!renderer->load_program(cloth_shader, "../shaders/cloth_vs.glsl", "../shaders/cloth_fs.glsl"))
+        return false;
+    if (!renderer->load_program(axis_shader, "../shaders/axis_vs.glsl", "../shaders/axis_fs.glsl"))
+        return false;
+    if (!renderer->load_program(grid_shader, "../shaders/grid_vs.glsl", "../shaders/grid_fs.glsl"))
+        return false;
+    // material never changes, so it is set once instead of every frame
+    glUseProgram(cloth_shader.id);
+    glUniform1f(cloth_shader.shininess, 128.f);
+    glUseProgram(0);
 
-    glGenVertexArrays(1, &sphere_vao2);
-    glBindVertexArray(sphere_vao2);
+    debug_overlay = new DebugOverlay();
+    if (!debug_overlay->init(*renderer))
+        return false;
 
-    glGenBuffers(1, &sphere_vbo_position2);
-    glBindBuffer(GL_ARRAY_BUFFER, sphere_vbo_position2);
-    glBufferData(GL_ARRAY_BUFFER, positions2.size() * sizeof(glm::vec3), &(positions2.front()), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+    mesh_cache = new MeshCache();
+    const Mesh& light_sphere = mesh_cache->get_ico_sphere(3);
+    sphere_draw_call_count = light_sphere.indices.size();
+    upload_mesh(light_sphere, sphere_vao, sphere_vbo_position, sphere_vbo_normal, sphere_ibo);
 
-    glBindVertexArray(NULL);
+    const Mesh& collider_sphere = mesh_cache->get_uv_sphere(sphere_radius, 20, 20);
+    sphere_draw_call_count2 = collider_sphere.indices.size();
+    upload_mesh(collider_sphere, sphere_vao2, sphere_vbo_position2, sphere_vbo_normal2, sphere_ibo2);
 
     const glm::vec3 vertices[] = {
             glm::vec3(0, 0, 0),
@@ -180,12 +257,58 @@ bool Application::init() {
 
     grid_draw_call_count = indices_grid.size() * 4;
 
-    cloth = new Cloth(55, 45);
+    if (distributed_cloth) {
+        distributed_cloth_mesh = new ClothMesh(cloth_width, cloth_height);
+    } else {
+        cloth = new Cloth(cloth_width, cloth_height);
+    }
+    wind_field = new WindField(wind_dir, 0.1f);
+
+    return true;
+}
 
+bool Application::start_distributed_cloth() {
+    // must run before the window, the GL context or any other thread exists: the workers are forked and use
+    // malloc and file I/O, which is only safe in the child of a single threaded process
+    if (cloth_domain_count <= 0)
+        return true;
+    distributed_cloth = new DistributedCloth(cloth_width, cloth_height, cloth_domain_count);
+    if (!distributed_cloth->start()) {
+        error("distributed cloth start error");
+        return false;
+    }
+    // the workers only get the per-step parameters in the shared header, the rest stays local
+    std::printf("distributed cloth: uniform wind at full resolution, wind field (G), LOD (L), mouse drag and debug overlay (C, P) are off\n");
     return true;
 }
 
+void Application::upload_mesh(const Mesh& mesh, unsigned& vao, unsigned& vbo_position, unsigned& vbo_normal, unsigned& ibo) {
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(1, &vbo_position);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_position);
+    glBufferData(GL_ARRAY_BUFFER, mesh.positions.size() * sizeof(glm::vec3), mesh.positions.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+
+    glGenBuffers(1, &vbo_normal);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_normal);
+    glBufferData(GL_ARRAY_BUFFER, mesh.normals.size() * sizeof(glm::vec3), mesh.normals.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+
+    glGenBuffers(1, &ibo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(NULL);
+}
+
 int Application::loop() {
+    if (offscreen)
+        return loop_offscreen();
+
     while (!glfwWindowShouldClose(window)) {
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             glfwSetWindowShouldClose(window, true);
@@ -206,10 +329,71 @@ int Application::loop() {
     return 0;
 }
 
+int Application::loop_offscreen() {
+    // no input, the simulation runs with its initial settings
+    for (int frame = 0; frame < offscreen_frame_count; frame++) {
+        float fixed_timestamp = 0.25f;
+        fixedUpdate(fixed_timestamp);
+
+        glClearColor(0, 0, 0, 0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        render();
+        recorder->capture();
+    }
+    recorder->finish();
+
+    return recorder->failed() ? -1 : 0;
+}
+
 void Application::fixedUpdate(float dt) {
-    cloth->add_wind_force(wind_dir);
+    if (distributed_cloth) {
+        // the workers run every phase, only the whole step is visible from here
+        double start = now_ms();
+        if (distributed_cloth->step(dt, wind_dir, sphere_prev_pos, sphere_pos, sphere_radius)) {
+            sphere_prev_pos = sphere_pos;
+            smooth(timings.solve, now_ms() - start);
+            return;
+        }
+        // a worker died, the cloth carries on in this process from the last step in shared memory
+        error("distributed simulation stopped, simulating locally");
+        std::vector<glm::vec3> positions;
+        distributed_cloth->gather(positions);
+        cloth = new Cloth(cloth_width, cloth_height);
+        cloth->set_positions(positions);
+        delete distributed_cloth;
+        distributed_cloth = nullptr;
+        delete distributed_cloth_mesh;
+        distributed_cloth_mesh = nullptr;
+    }
+
+    double start = now_ms();
+    update_cloth_lod();
+    double lod_end = now_ms();
+    if (use_wind_field) {
+        wind_field->set_base_direction(wind_dir);
+        wind_field->update(dt);
+        cloth->add_wind_force(*wind_field);
+    } else {
+        cloth->add_wind_force(wind_dir);
+    }
+    double wind_end = now_ms();
     cloth->update(dt);
-    cloth->collision_detection_with_sphere(sphere_pos, sphere_radius);
+    double solve_end = now_ms();
+    cloth->continuous_collision_with_sphere(sphere_prev_pos, sphere_pos, sphere_radius);
+    sphere_prev_pos = sphere_pos;
+    cloth->refit_bvh();
+    double collision_end = now_ms();
+
+    smooth(timings.lod, lod_end - start);
+    smooth(timings.wind, wind_end - lod_end);
+    smooth(timings.solve, solve_end - wind_end);
+    smooth(timings.collision, collision_end - solve_end);
+}
+
+bool Application::key_pressed(int key) {
+    bool down = glfwGetKey(window, key) == GLFW_PRESS;
+    bool was_down = std::exchange(key_down[key], down);
+    return down && !was_down;
 }
 
 void Application::update(float dt) {
@@ -219,7 +403,13 @@ void Application::update(float dt) {
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) viewPos += right * speed;
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) viewPos += up * speed;
     if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) viewPos += -up * speed;
-    if (glfwGetKey(window, GLFW_KEY_TAB) == GLFW_PRESS) is_wireframe = !is_wireframe;
+    if (key_pressed(GLFW_KEY_TAB)) is_wireframe = !is_wireframe;
+    if (key_pressed(GLFW_KEY_L)) use_cloth_lod = !use_cloth_lod;
+    if (key_pressed(GLFW_KEY_G)) use_wind_field = !use_wind_field;
+    if (key_pressed(GLFW_KEY_V)) use_compact_vertices = !use_compact_vertices;
+    if (key_pressed(GLFW_KEY_C)) show_constraint_strain = !show_constraint_strain;
+    if (key_pressed(GLFW_KEY_P)) show_particle_state = !show_particle_state;
+    if (key_pressed(GLFW_KEY_H)) show_hud = !show_hud;
     if (is_wireframe) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     } else {
@@ -232,64 +422,232 @@ void Application::update(float dt) {
     if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) sphere_pos += right * speed;
     if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS) sphere_pos += up * speed;
     if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS) sphere_pos += -up * speed;
+
+    update_cloth_drag();
 }
 
-void Application::render() {
-    glm::mat4 model = glm::identity<glm::mat4>();
-    model = glm::translate(model, glm::vec3(0.f, 1.f, 0.f));
+void Application::update_cloth_drag() {
+    // nothing local to pick while the workers simulate, and they don't know about attachments
+    if (distributed_cloth)
+        return;
+    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) != GLFW_PRESS) {
+        if (cloth->has_attachment()) cloth->release_attachment();
+        return;
+    }
+
+    // cloth particles are in model space, the cloth model matrix is a plain translation
+    glm::vec3 origin, direction;
+    get_cursor_ray(origin, direction);
+    origin -= cloth_pos;
+    if (cloth->has_attachment()) {
+        cloth->move_attachment(origin + direction * drag_distance);
+        return;
+    }
+
+    float t = 0.f;
+    int particle = -1;
+    if (cloth->raycast(origin, direction, t, particle)) {
+        drag_distance = t;
+        cloth->attach(particle, origin + direction * t);
+    }
+}
+
+void Application::get_cursor_ray(glm::vec3& out_origin, glm::vec3& out_direction) const {
+    double cursor_x = 0.0, cursor_y = 0.0;
+    glfwGetCursorPos(window, &cursor_x, &cursor_y);
+    float ndc_x = 2.f * (float)cursor_x / (float)window_width - 1.f;
+    float ndc_y = 1.f - 2.f * (float)cursor_y / (float)window_height;
+
     glm::mat4 view = glm::lookAt(viewPos, viewPos + forward, up);
     glm::mat4 perspective = glm::perspective(fieldOfView, (float)window_width / (float)window_height, nearClipPlane, farClipPlane);
-    float attenuation = 0.05f, intensity = 0.5f, shininess = 128.f;
-    glm::vec3 color = glm::vec3(1.f, 1.f, 1.f), lightPos = glm::vec3(3.17f, 2.34f, -4.184f);
-
-    glUseProgram(cloth_shader);
-    glUniformMatrix4fv(glGetUniformLocation(cloth_shader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(cloth_shader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(cloth_shader, "projection"), 1, GL_FALSE, glm::value_ptr(perspective));
-    glUniformMatrix4fv(glGetUniformLocation(cloth_shader, "viewPos"), 1, GL_FALSE, glm::value_ptr(viewPos));
-    glUniformMatrix4fv(glGetUniformLocation(cloth_shader, "pointLights[0].position"), 1, GL_FALSE, glm::value_ptr(lightPos));
-    glUniform3fv(glGetUniformLocation(cloth_shader, "pointLights[0].color"), 1, glm::value_ptr(color));
-    glUniform1f(glGetUniformLocation(cloth_shader, "pointLights[0].attenuation"), attenuation);
-    glUniform1f(glGetUniformLocation(cloth_shader, "pointLights[0].intensity"), intensity);
-    glUniform1f(glGetUniformLocation(cloth_shader, "material.shininess"), shininess);
-    cloth->render();
-
-    model = glm::identity<glm::mat4>();
-    model = glm::translate(model, lightPos);
-    model = glm::scale(model, glm::vec3(0.2, 0.2, 0.2));
-    glUniformMatrix4fv(glGetUniformLocation(cloth_shader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glBindVertexArray(sphere_vao);
-    glDrawElements(GL_TRIANGLES, sphere_draw_call_count, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(NULL);
+    glm::mat4 inv_view_projection = glm::inverse(perspective * view);
+    glm::vec4 near_point = inv_view_projection * glm::vec4(ndc_x, ndc_y, -1.f, 1.f);
+    glm::vec4 far_point = inv_view_projection * glm::vec4(ndc_x, ndc_y, 1.f, 1.f);
+    out_origin = glm::vec3(near_point.x, near_point.y, near_point.z) / near_point.w;
+    out_direction = glm::normalize(glm::vec3(far_point.x, far_point.y, far_point.z) / far_point.w - out_origin);
+}
 
-    model = glm::identity<glm::mat4>();
-    model = glm::translate(model, sphere_pos);
-    glUniformMatrix4fv(glGetUniformLocation(cloth_shader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glBindVertexArray(sphere_vao2);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, sphere_draw_call_count2);
-    glBindVertexArray(NULL);
+void Application::update_cloth_lod() {
+    // a dragged particle has to be simulated, not interpolated
+    if (!use_cloth_lod || cloth->has_attachment()) {
+        cloth->set_lod_level(0);
+        return;
+    }
 
-    glUseProgram(grid_shader);
-    model = glm::identity<glm::mat4>();
-    model = glm::scale(model, glm::vec3(50.f, 50.f, 50.f));
-    model = glm::translate(model, glm::vec3(-0.5f, 0.f, -0.5f));
-    glUniformMatrix4fv(glGetUniformLocation(grid_shader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(grid_shader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(grid_shader, "projection"), 1, GL_FALSE, glm::value_ptr(perspective));
-    glUniform4f(glGetUniformLocation(grid_shader, "aFragColor"), grid_color.x, grid_color.y, grid_color.z, grid_color.w);
-    glBindVertexArray(grid_vao);
-    glDrawElements(GL_LINES, grid_draw_call_count, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(NULL);
+    const auto& [min, max] = cloth->get_bounds();
+    glm::mat4 model = glm::translate(glm::identity<glm::mat4>(), cloth_pos);
+    glm::mat4 view = glm::lookAt(viewPos, viewPos + forward, up);
+    glm::mat4 perspective = glm::perspective(fieldOfView, (float)window_width / (float)window_height, nearClipPlane, farClipPlane);
+    glm::mat4 mvp = perspective * view * model;
+
+    // offscreen when all corners of the bounding box are outside of the same clip plane. The planes are pushed out
+    // a bit, further to enter the offscreen state than to leave it, so the switch happens out of view and
+    // a cloth sitting at the edge of the screen doesn't toggle between levels.
+    float margin = cloth_offscreen ? 1.05f : 1.15f;
+    unsigned outside = 0x3f;
+    for (int i = 0; i < 8; ++i) {
+        glm::vec4 corner = mvp * glm::vec4(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z, 1.f);
+        float w = corner.w * margin;
+        unsigned planes = 0;
+        if (corner.x < -w) planes |= 1 << 0;
+        if (corner.x > w) planes |= 1 << 1;
+        if (corner.y < -w) planes |= 1 << 2;
+        if (corner.y > w) planes |= 1 << 3;
+        if (corner.z < -corner.w) planes |= 1 << 4;
+        if (corner.z > corner.w) planes |= 1 << 5;
+        outside &= planes;
+    }
+    cloth_offscreen = outside != 0;
+    if (cloth_offscreen) {
+        cloth->set_lod_level(Cloth::max_lod_level);
+        return;
+    }
 
-    glDisable(GL_DEPTH_TEST); // to make axis line always front of all the objects.
-    glUseProgram(axis_shader);
-    model = glm::identity<glm::mat4>();
-    glUniformMatrix4fv(glGetUniformLocation(axis_shader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(axis_shader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(axis_shader, "projection"), 1, GL_FALSE, glm::value_ptr(perspective));
-    glUniform4f(glGetUniformLocation(axis_shader, "aFragColor"), grid_color.x, grid_color.y, grid_color.z, grid_color.w);
-    glBindVertexArray(axis_line_vao);
-    glDrawArrays(GL_LINES, 0, 6);
-    glBindVertexArray(NULL);
-    glEnable(GL_DEPTH_TEST);
+    // level n covers distances from n to n + 1 times cloth_lod_distance, a level is only left once the distance
+    // is past its range by the hysteresis band, so hovering around a threshold doesn't switch every step
+    float distance = glm::length(cloth_pos + (min + max) * 0.5f - viewPos);
+    float band = cloth_lod_distance * cloth_lod_hysteresis;
+    int level = glm::min(cloth->get_lod_level(), Cloth::max_lod_level);
+    while (level < Cloth::max_lod_level && distance > (level + 1) * cloth_lod_distance + band) ++level;
+    while (level > 0 && distance < level * cloth_lod_distance - band) --level;
+    cloth->set_lod_level(level);
+}
+
+void Application::render() {
+    double start = now_ms();
+    if (last_frame_time > 0.0)
+        smooth(timings.frame, start - last_frame_time);
+    last_frame_time = start;
+
+    FrameData frame{};
+    frame.view = glm::lookAt(viewPos, viewPos + forward, up);
+    frame.projection = glm::perspective(fieldOfView, (float)window_width / (float)window_height, nearClipPlane, farClipPlane);
+    frame.view_pos = glm::vec4(viewPos, 1.f);
+    frame.point_lights[0].position = glm::vec3(3.17f, 2.34f, -4.184f);
+    frame.point_lights[0].color = glm::vec3(1.f, 1.f, 1.f);
+    frame.point_lights[0].attenuation = 0.05f;
+    frame.point_lights[0].intensity = 0.5f;
+    renderer->begin_frame(frame);
+
+    DrawCommand command;
+    command.program = &cloth_shader;
+    command.mode = GL_TRIANGLES;
+    command.model = glm::translate(glm::identity<glm::mat4>(), cloth_pos);
+    if (distributed_cloth_mesh) {
+        // straight from the mapping, the workers are parked between steps
+        distributed_cloth_mesh->set_compact_vertices(use_compact_vertices);
+        distributed_cloth_mesh->update(PositionView(distributed_cloth->get_positions(), sizeof(glm::vec3)));
+        command.vao = distributed_cloth_mesh->get_vao();
+        command.count = distributed_cloth_mesh->get_vertex_count();
+        std::tie(command.position_offset, command.position_scale) = distributed_cloth_mesh->get_position_decode();
+    } else {
+        cloth->set_compact_vertices(use_compact_vertices);
+        cloth->rebuild_vertex_buffer();
+        command.vao = cloth->get_vao();
+        command.count = cloth->get_vertex_count();
+        std::tie(command.position_offset, command.position_scale) = cloth->get_position_decode();
+    }
+    renderer->submit(command);
+
+    command = DrawCommand();
+    command.program = &cloth_shader;
+    command.vao = sphere_vao;
+    command.mode = GL_TRIANGLES;
+    command.count = sphere_draw_call_count;
+    command.indexed = true;
+    command.model = glm::translate(glm::identity<glm::mat4>(), frame.point_lights[0].position);
+    command.model = glm::scale(command.model, glm::vec3(0.2, 0.2, 0.2));
+    renderer->submit(command);
+
+    command = DrawCommand();
+    command.program = &cloth_shader;
+    command.vao = sphere_vao2;
+    command.mode = GL_TRIANGLES;
+    command.count = sphere_draw_call_count2;
+    command.indexed = true;
+    command.model = glm::translate(glm::identity<glm::mat4>(), sphere_pos);
+    renderer->submit(command);
+
+    command = DrawCommand();
+    command.program = &grid_shader;
+    command.vao = grid_vao;
+    command.mode = GL_LINES;
+    command.count = grid_draw_call_count;
+    command.indexed = true;
+    command.model = glm::scale(glm::identity<glm::mat4>(), glm::vec3(50.f, 50.f, 50.f));
+    command.model = glm::translate(command.model, glm::vec3(-0.5f, 0.f, -0.5f));
+    command.color = grid_color;
+    renderer->submit(command);
+
+    // overlay to make axis line always front of all the objects.
+    command = DrawCommand();
+    command.program = &axis_shader;
+    command.vao = axis_line_vao;
+    command.mode = GL_LINES;
+    command.count = 6;
+    command.overlay = true;
+    renderer->submit(command);
+
+    renderer->flush();
+
+    // constraints and per particle state only exist in a local Cloth
+    if (cloth) {
+        glm::mat4 cloth_model = glm::translate(glm::identity<glm::mat4>(), cloth_pos);
+        debug_overlay->draw(*cloth, cloth_model, show_constraint_strain, show_particle_state);
+    }
+    // cpu time spent submitting, the GPU may still be working on it
+    smooth(timings.render, now_ms() - start);
+
+    if (show_hud && init_hud())
+        draw_hud();
+}
+
+bool Application::init_hud() {
+    // the atlas is only built once the HUD is shown, and a missing font only disables the HUD
+    if (text_renderer || hud_unavailable)
+        return text_renderer != nullptr;
+
+    std::vector<std::string> hud_fonts;
+    if (!hud_font.empty())
+        hud_fonts.push_back(hud_font);
+#ifdef CLOTH_HUD_FONT
+    hud_fonts.push_back(CLOTH_HUD_FONT);
+#endif
+    text_renderer = new TextRenderer();
+    if (text_renderer->init(*renderer)) {
+        for (const std::string& font : hud_fonts) {
+            if (text_renderer->load_font(font, 16))
+                return true;
+        }
+    }
+    error("no HUD font found (--font <path> or CLOTH_HUD_FONT), the HUD is disabled");
+    delete text_renderer;
+    text_renderer = nullptr;
+    hud_unavailable = true;
+    return false;
+}
+
+void Application::draw_hud() {
+    char cloth_stats[128];
+    if (cloth) {
+        std::snprintf(cloth_stats, sizeof(cloth_stats), "particles %d  constraints %d  lod %d",
+                      cloth->get_particle_count(), cloth->get_constraint_count(), cloth->get_lod_level());
+    } else {
+        std::snprintf(cloth_stats, sizeof(cloth_stats), "particles %d  domains %d",
+                      cloth_width * cloth_height, distributed_cloth->get_domain_count());
+    }
+    char text[512];
+    float fps = timings.frame > 0.f ? 1000.f / timings.frame : 0.f;
+    std::snprintf(text, sizeof(text),
+                  "frame     %6.2f ms  %5.0f fps\n"
+                  "lod       %6.2f ms\n"
+                  "wind      %6.2f ms\n"
+                  "solve     %6.2f ms\n"
+                  "collision %6.2f ms\n"
+                  "render    %6.2f ms\n"
+                  "%s",
+                  timings.frame, fps, timings.lod, timings.wind, timings.solve, timings.collision, timings.render,
+                  cloth_stats);
+    text_renderer->add_text(text, 10.f, 10.f, glm::vec4(1.f, 1.f, 1.f, 0.9f));
+    text_renderer->draw(window_width, window_height);
 }
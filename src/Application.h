@@ -1,43 +1,100 @@
 #ifndef CLOTH_SIMULATION_APPLICATION_H
 #define CLOTH_SIMULATION_APPLICATION_H
 
+#include "Renderer.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 class GLFWwindow;
 class Cloth;
+class ClothMesh;
+class DistributedCloth;
+class WindField;
+class OffscreenContext;
+class FrameRecorder;
+class MeshCache;
+class DebugOverlay;
+class TextRenderer;
+struct Mesh;
 class Application {
 public:
   Application(std::string title, int w, int h);
   ~Application();
 
+  // both before initApp or initOffscreen
+  void set_cloth_size(int w, int h);
+  void set_cloth_domain_count(int count); // 0 simulates in this process
+  void set_hud_font(const std::string& path); // tried before the CLOTH_HUD_FONT build default
+
   bool initApp();
+  bool initOffscreen(const std::string& output_dir, int frame_count); // renders frame_count frames to PNG files, no window
   int loop();
 
 private:
+  bool start_distributed_cloth();
   bool init();
   void fixedUpdate(float dt);
   void update(float dt);
+  bool key_pressed(int key); // true only on the frame the key goes down
   void render();
+  int loop_offscreen();
+  void upload_mesh(const Mesh& mesh, unsigned& vao, unsigned& vbo_position, unsigned& vbo_normal, unsigned& ibo);
+  void update_cloth_lod();
+  void update_cloth_drag();
+  void get_cursor_ray(glm::vec3& out_origin, glm::vec3& out_direction) const;
+  bool init_hud();
+  void draw_hud();
 
 private:
   int window_width, window_height;
   std::string app_title;
-  unsigned cloth_shader{}, axis_shader{}, grid_shader{};
+  ShaderProgram cloth_shader, axis_shader, grid_shader;
   unsigned sphere_vao{}, sphere_vbo_position{}, sphere_vbo_normal{}, sphere_ibo{};
   unsigned axis_line_vao{}, axis_line_vbo{};
-  unsigned sphere_vao2{}, sphere_vbo_position2{};
+  unsigned sphere_vao2{}, sphere_vbo_position2{}, sphere_vbo_normal2{}, sphere_ibo2{};
   unsigned grid_vao{}, grid_vbo{}, grid_ibo{};
   glm::vec4 grid_color = glm::vec4(0, 1, 1, 1);
   glm::vec3 wind_dir = glm::vec3(12, 0, 0.6), viewPos = glm::vec3(0.27, -0.17, 2.04);
   glm::vec3 forward = glm::vec3(0.f, 0.f, -1.f), up = glm::vec3(0.f, 1.f, 0.f), right = glm::cross(forward, up);
   float nearClipPlane = 0.1f, farClipPlane = 100.f, fieldOfView = glm::radians(45.f), speed = 0.04f;
   bool is_wireframe = true;
+  std::unordered_map<int, bool> key_down; // state seen by key_pressed last frame
   unsigned grid_draw_call_count = 0, sphere_draw_call_count = 0, sphere_draw_call_count2 = 0;
-  glm::vec3 sphere_pos = glm::vec3(0, 0, 0);
+  glm::vec3 cloth_pos = glm::vec3(0.f, 1.f, 0.f);
+  float cloth_lod_distance = 4.f; // camera distance covered by each LOD level
+  float cloth_lod_hysteresis = 0.1f; // fraction of cloth_lod_distance a level is kept past its range
+  bool cloth_offscreen = false;
+  bool use_cloth_lod = true;
+  float drag_distance = 0.f; // along the cursor ray, fixed while a particle is dragged
+  glm::vec3 sphere_pos = glm::vec3(0, 0, 0), sphere_prev_pos = sphere_pos;
   float sphere_radius = 0.2;
   GLFWwindow* window{};
+  Renderer* renderer{};
   Cloth* cloth{};
+  WindField* wind_field{};
+  bool use_wind_field = true;
+  bool use_compact_vertices = false; // V opts into the packed vertex format
+  bool show_constraint_strain = false, show_particle_state = false;
+  int cloth_width = 55, cloth_height = 45;
+  int cloth_domain_count = 0; // > 0 simulates the cloth in that many worker processes, cloth only renders it
+  DistributedCloth* distributed_cloth{};
+  ClothMesh* distributed_cloth_mesh{}; // draws the shared positions, no Cloth exists while the workers run
+  OffscreenContext* offscreen{};
+  FrameRecorder* recorder{};
+  MeshCache* mesh_cache{};
+  DebugOverlay* debug_overlay{};
+  TextRenderer* text_renderer{};
+  bool show_hud = true; // off when rendering offscreen
+  bool hud_unavailable = false; // no font could be loaded
+  std::string hud_font;
+  // HUD timings in milliseconds, smoothed over the last frames so the numbers stay readable
+  struct {
+    float frame, lod, wind, solve, collision, render;
+  } timings{};
+  double last_frame_time = 0.0;
+  int offscreen_frame_count = 0;
 };
 
 #endif //CLOTH_SIMULATION_APPLICATION_H
@@ -0,0 +1,190 @@
+#include "BVH.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+  bool intersect_box(const glm::vec3& origin, const glm::vec3& inv_direction, const glm::vec3& min, const glm::vec3& max, float t_max, float& out_t) {
+      float t0 = 0.f, t1 = t_max;
+      for (int axis = 0; axis < 3; ++axis) {
+          float near = (min[axis] - origin[axis]) * inv_direction[axis];
+          float far = (max[axis] - origin[axis]) * inv_direction[axis];
+          if (near > far) std::swap(near, far);
+          t0 = near > t0 ? near : t0;
+          t1 = far < t1 ? far : t1;
+          if (t0 > t1) return false;
+      }
+      out_t = t0;
+      return true;
+  }
+
+  bool contains(const glm::vec3& outer_min, const glm::vec3& outer_max, const glm::vec3& inner_min, const glm::vec3& inner_max) {
+      for (int axis = 0; axis < 3; ++axis) {
+          if (inner_min[axis] < outer_min[axis] || inner_max[axis] > outer_max[axis]) return false;
+      }
+      return true;
+  }
+
+  // Moller-Trumbore
+  bool intersect_triangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, RayHit& out_hit) {
+      glm::vec3 edge1 = b - a, edge2 = c - a;
+      glm::vec3 p = glm::cross(direction, edge2);
+      float det = glm::dot(edge1, p);
+      if (std::abs(det) < 1e-12f) return false;
+      float inv_det = 1.f / det;
+      glm::vec3 s = origin - a;
+      float u = glm::dot(s, p) * inv_det;
+      if (u < 0.f || u > 1.f) return false;
+      glm::vec3 q = glm::cross(s, edge1);
+      float v = glm::dot(direction, q) * inv_det;
+      if (v < 0.f || u + v > 1.f) return false;
+      float t = glm::dot(edge2, q) * inv_det;
+      if (t < 0.f) return false;
+      out_hit.t = t;
+      out_hit.u = u;
+      out_hit.v = v;
+      return true;
+  }
+}
+
+void BVH::build(const std::vector<glm::uvec3>& triangles, const PositionView& positions, float margin) {
+    m_triangles = triangles;
+    m_margin = margin;
+    m_nodes.clear();
+    if (m_triangles.empty()) return;
+    m_nodes.reserve(2 * m_triangles.size() / max_leaf_size + 1);
+
+    std::vector<glm::vec3> centroids{};
+    centroids.reserve(m_triangles.size());
+    for (const auto& triangle : m_triangles) {
+        centroids.push_back((positions[triangle.x] + positions[triangle.y] + positions[triangle.z]) / 3.f);
+    }
+    build_node(0, (int)m_triangles.size(), centroids);
+    refit(positions);
+}
+
+int BVH::build_node(int first, int count, std::vector<glm::vec3>& centroids) {
+    int index = (int)m_nodes.size();
+    // an empty box, so the first refit writes every leaf
+    const float inf = std::numeric_limits<float>::infinity();
+    m_nodes.push_back(Node{glm::vec3(inf), glm::vec3(-inf), 0, 0});
+    if (count <= max_leaf_size) {
+        m_nodes[index].first = first;
+        m_nodes[index].count = count;
+        return index;
+    }
+
+    // median split along the widest axis of the centroids, triangles and centroids are sorted together
+    glm::vec3 min = centroids[first], max = min;
+    for (int i = first; i < first + count; ++i) {
+        min = glm::min(min, centroids[i]);
+        max = glm::max(max, centroids[i]);
+    }
+    glm::vec3 extent = max - min;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    std::vector<int> order(count);
+    for (int i = 0; i < count; ++i) order[i] = first + i;
+    int half = count / 2;
+    std::nth_element(order.begin(), order.begin() + half, order.end(), [&](int a, int b) { return centroids[a][axis] < centroids[b][axis]; });
+    std::vector<glm::uvec3> triangles(count);
+    std::vector<glm::vec3> sorted_centroids(count);
+    for (int i = 0; i < count; ++i) {
+        triangles[i] = m_triangles[order[i]];
+        sorted_centroids[i] = centroids[order[i]];
+    }
+    std::copy(triangles.begin(), triangles.end(), m_triangles.begin() + first);
+    std::copy(sorted_centroids.begin(), sorted_centroids.end(), centroids.begin() + first);
+
+    build_node(first, half, centroids);
+    int right = build_node(first + half, count - half, centroids);
+    m_nodes[index].first = right;
+    m_nodes[index].count = 0;
+    return index;
+}
+
+int BVH::refit(const PositionView& positions) {
+    // children always come after their parent, so a reverse sweep sees them first
+    int refit_leaves = 0;
+    for (int i = (int)m_nodes.size() - 1; i >= 0; --i) {
+        Node& node = m_nodes[i];
+        if (node.count > 0) {
+            refit_leaves += fit_leaf(node, positions);
+        } else {
+            const Node& left = m_nodes[i + 1];
+            const Node& right = m_nodes[node.first];
+            node.min = glm::min(left.min, right.min);
+            node.max = glm::max(left.max, right.max);
+        }
+    }
+    return refit_leaves;
+}
+
+bool BVH::fit_leaf(Node& node, const PositionView& positions) const {
+    glm::vec3 min = positions[m_triangles[node.first].x], max = min;
+    for (int i = node.first; i < node.first + node.count; ++i) {
+        const glm::uvec3& triangle = m_triangles[i];
+        for (int k = 0; k < 3; ++k) {
+            min = glm::min(min, positions[triangle[k]]);
+            max = glm::max(max, positions[triangle[k]]);
+        }
+    }
+
+    // still enclosed, and no more than twice the margin larger than needed
+    glm::vec3 slack = glm::vec3(2.f * m_margin);
+    if (contains(node.min, node.max, min, max) && contains(min - slack, max + slack, node.min, node.max)) return false;
+
+    node.min = min - glm::vec3(m_margin);
+    node.max = max + glm::vec3(m_margin);
+    return true;
+}
+
+bool BVH::raycast(const glm::vec3& origin, const glm::vec3& direction, const PositionView& positions, RayHit& out_hit) const {
+    if (m_nodes.empty()) return false;
+
+    const float inf = std::numeric_limits<float>::infinity();
+    glm::vec3 inv_direction = glm::vec3(direction.x != 0.f ? 1.f / direction.x : inf,
+                                        direction.y != 0.f ? 1.f / direction.y : inf,
+                                        direction.z != 0.f ? 1.f / direction.z : inf);
+    float closest = inf, t = 0.f;
+    out_hit.triangle = -1;
+
+    int stack[64];
+    int stack_size = 0;
+    if (intersect_box(origin, inv_direction, m_nodes[0].min, m_nodes[0].max, closest, t)) stack[stack_size++] = 0;
+    while (stack_size > 0) {
+        const Node& node = m_nodes[stack[--stack_size]];
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                const glm::uvec3& triangle = m_triangles[i];
+                RayHit hit{};
+                if (intersect_triangle(origin, direction, positions[triangle.x], positions[triangle.y], positions[triangle.z], hit) && hit.t < closest) {
+                    closest = hit.t;
+                    out_hit = hit;
+                    out_hit.triangle = i;
+                }
+            }
+            continue;
+        }
+
+        // visit the nearer child first, it is pushed last
+        int left = (int)(&node - m_nodes.data()) + 1, right = node.first;
+        float t_left = 0.f, t_right = 0.f;
+        bool hit_left = intersect_box(origin, inv_direction, m_nodes[left].min, m_nodes[left].max, closest, t_left);
+        bool hit_right = intersect_box(origin, inv_direction, m_nodes[right].min, m_nodes[right].max, closest, t_right);
+        if (hit_left && hit_right) {
+            if (t_left < t_right) std::swap(left, right);
+            stack[stack_size++] = left;
+            stack[stack_size++] = right;
+        } else if (hit_left) {
+            stack[stack_size++] = left;
+        } else if (hit_right) {
+            stack[stack_size++] = right;
+        }
+    }
+    return out_hit.triangle >= 0;
+}
+
+const glm::uvec3& BVH::get_triangle(int triangle) const {
+    return m_triangles[triangle];
+}
@@ -0,0 +1,53 @@
+#ifndef CLOTH_SIMULATION_BVH_H
+#define CLOTH_SIMULATION_BVH_H
+
+#include <glm/gtc/type_ptr.hpp>
+#include <vector>
+
+struct RayHit {
+  int triangle = -1;
+  float t = 0.f, u = 0.f, v = 0.f; // distance along the ray and barycentric coordinates of the 2nd and 3rd vertex
+};
+
+// Vertex positions read in place, stride bytes apart, so a member of an array of structs needs no copy.
+class PositionView {
+public:
+  PositionView(const std::vector<glm::vec3>& positions) : m_first{reinterpret_cast<const char*>(positions.data())}, m_stride{sizeof(glm::vec3)} {}
+  PositionView(const glm::vec3* first, size_t stride) : m_first{reinterpret_cast<const char*>(first)}, m_stride{stride} {}
+
+  const glm::vec3& operator[](size_t i) const { return *reinterpret_cast<const glm::vec3*>(m_first + i * m_stride); }
+
+private:
+  const char* m_first;
+  size_t m_stride;
+};
+
+// Bounding volume hierarchy over an indexed triangle mesh whose topology never changes.
+// The tree is built once and only its boxes are recomputed when the vertices move. Leaf boxes are padded by a
+// margin, a leaf is only rewritten once its triangles leave the padded box or the box gets too loose.
+class BVH {
+public:
+  void build(const std::vector<glm::uvec3>& triangles, const PositionView& positions, float margin = 0.f);
+  int refit(const PositionView& positions); // returns the number of leaves rewritten
+  bool raycast(const glm::vec3& origin, const glm::vec3& direction, const PositionView& positions, RayHit& out_hit) const;
+
+  const glm::uvec3& get_triangle(int triangle) const;
+
+private:
+  struct Node {
+    glm::vec3 min, max;
+    int first; // first triangle for a leaf, right child for an inner node (the left child follows its parent)
+    int count; // triangles in a leaf, 0 for an inner node
+  };
+
+  int build_node(int first, int count, std::vector<glm::vec3>& centroids);
+  bool fit_leaf(Node& node, const PositionView& positions) const;
+
+private:
+  static constexpr int max_leaf_size = 4;
+  float m_margin = 0.f;
+  std::vector<glm::uvec3> m_triangles;
+  std::vector<Node> m_nodes;
+};
+
+#endif //CLOTH_SIMULATION_BVH_H
@@ -3,6 +3,8 @@
 
 #include <vector>
 #include <cassert>
+#include <cstring>
+#include <type_traits>
 
 template<typename T>
 class Bitmap {
@@ -34,7 +36,9 @@ Bitmap<T>::Bitmap(int w, int h, T val) : data() {
 
 template <typename T>
 Bitmap<T>& Bitmap<T>::operator=(Bitmap<T> const& other) {
-    replace_part(other, 0, 0);
+    width = other.width;
+    height = other.height;
+    data = other.data;
     return *this;
 }
 
@@ -48,7 +52,7 @@ void Bitmap<T>::clear(int w, int h, T val) {
 
 template <typename T>
 int Bitmap<T>::get_idx(const int x, const int y) const {
-    if (x < 0 || y < 0 || x > width || y > height) {
+    if (x < 0 || y < 0 || x >= width || y >= height) {
         return -1;
     }
     int rows_from_bottom = (height - 1) - y;
@@ -75,14 +79,17 @@ void Bitmap<T>::set(const int x, const int y, const T val) {
 
 template <typename T>
 bool Bitmap<T>::replace_part(Bitmap<T> const& other, int x_left, int y_bottom) {
-    if ((x_left + other.width) > width || (y_bottom + other.height) > height) {
+    static_assert(std::is_trivially_copyable<T>::value, "rows are copied with memcpy");
+    if (x_left < 0 || y_bottom < 0 || (x_left + other.width) > width || (y_bottom + other.height) > height) {
         return false;
     }
+    if (other.width == 0) {
+        return true;
+    }
 
+    // rows are contiguous in both bitmaps, bounds are checked once above
     for (int row = 0; row < other.height; row ++) {
-        for (int col = 0; col < other.width; col++) {
-            set(col + x_left, row + y_bottom, other.get(col, row));
-        }
+        memcpy(&data[get_idx(x_left, row + y_bottom)], &other.data[other.get_idx(0, row)], other.width * sizeof(T));
     }
     return true;
 }
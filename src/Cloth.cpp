@@ -1,5 +1,5 @@
 #include "Cloth.h"
-#include <GL/glew.h>
+#include "WindField.h"
 
 glm::vec3 Cloth::gravity_dir = glm::vec3(0.f, -0.2f, 0.f);
 
@@ -7,10 +7,9 @@ Particle::Particle(const glm::vec3 &position) : m_position{position}, m_old_posi
 
 }
 
-glm::vec3 Particle::get_position() const { return m_position; }
-glm::vec3& Particle::get_normal() { return m_accumulated_normal; }
-void Particle::add_to_normal(glm::vec3& normal) { m_accumulated_normal += normal; }
-void Particle::reset_normal() { m_accumulated_normal = glm::vec3(0, 0, 0); }
+const glm::vec3& Particle::get_position() const { return m_position; }
+glm::vec3 Particle::get_old_position() const { return m_old_position; }
+bool Particle::is_movable() const { return m_is_movable; }
 
 void Particle::offset_pos(const glm::vec3 &v) {
     if (m_is_movable) {
@@ -18,6 +17,13 @@ void Particle::offset_pos(const glm::vec3 &v) {
     }
 }
 
+void Particle::set_state(const glm::vec3& position, const glm::vec3& old_position) {
+    if (m_is_movable) {
+        m_position = position;
+        m_old_position = old_position;
+    }
+}
+
 void Particle::set_movable(bool movable) {
     m_is_movable = movable;
 }
@@ -48,7 +54,11 @@ void Constraint::satisfy() {
     m_p2->offset_pos(-correction_vec_half);
 }
 
-Cloth::Cloth(int w, int h) : m_width{w}, m_height{h} {
+const Particle* Constraint::get_first() const { return m_p1; }
+const Particle* Constraint::get_second() const { return m_p2; }
+float Constraint::get_rest_distance() const { return m_rest_distance; }
+
+Cloth::Cloth(int w, int h) : m_width{w}, m_height{h}, m_mesh{w, h} {
     m_particles.resize(m_width * m_height);
 
     // creating particles in a grid of particles from (0,0,0) to (width,-height,0)
@@ -83,6 +93,11 @@ Cloth::Cloth(int w, int h) : m_width{w}, m_height{h} {
         }
     }
 
+    // coarser simulation lattices, rest distances must be taken from the undeformed grid
+    for (int level = 1; level <= max_lod_level; ++level) {
+        build_lod_level(1 << level);
+    }
+
     // disable top 3 particle to hold cloth
     for (int i = 0; i< 3; i++) {
         get_particle(0 + i, 0)->offset_pos(glm::vec3(0.5,0.0,0.0));
@@ -91,97 +106,96 @@ Cloth::Cloth(int w, int h) : m_width{w}, m_height{h} {
         get_particle(0+i ,0)->offset_pos(glm::vec3(-0.5,0.0,0.0));
         get_particle(0 + m_width - 1 - i ,0)->set_movable(false);
     }
-    rebuild_vertex_buffer(true);
-}
-
-Cloth::~Cloth() {
-    glDeleteVertexArrays(1, &vao);
-    glDeleteBuffers(1, &vbo);
-    glDeleteBuffers(1, &vbo2);
-}
+    rebuild_vertex_buffer();
 
-std::tuple<std::vector<glm::vec3>, std::vector<glm::vec3>, std::vector<glm::vec2>> Cloth::make_data_buffer() {
-    std::vector<glm::vec3> vertex_position_buffer{};
-    vertex_position_buffer.reserve(6 * m_width * m_height);
-    std::vector<glm::vec3> vertex_normal_buffer{};
-    vertex_normal_buffer.reserve(6 * m_width * m_height);
-    std::vector<glm::vec2> vertex_tex_buffer{};
-    for(Particle& p : m_particles) {
-        p.reset_normal();
+    // picking structure over the same triangles that are rendered
+    std::vector<glm::uvec3> triangles{};
+    triangles.reserve(2 * (m_width - 1) * (m_height - 1));
+    for (int x = 0; x < m_width - 1; ++x) {
+        for (int y = 0; y < m_height - 1; ++y) {
+            triangles.emplace_back(glm::uvec3(y * m_width + x + 1, y * m_width + x, (y + 1) * m_width + x));
+            triangles.emplace_back(glm::uvec3((y + 1) * m_width + x + 1, y * m_width + x + 1, (y + 1) * m_width + x));
+        }
     }
+    // half a grid cell, a leaf survives a few steps of slow motion without being rewritten
+    m_bvh.build(triangles, get_particle_positions(), 0.5f / glm::max(m_width, m_height));
+}
 
-    for (int x = 0; x < m_width - 1; x++) {
-        for (int y = 0; y < m_height - 1; y++) {
-            vertex_position_buffer.emplace_back(get_particle(x + 1, y)->get_position());
-            vertex_position_buffer.emplace_back(get_particle(x, y)->get_position());
-            vertex_position_buffer.emplace_back(get_particle(x, y + 1)->get_position());
-            glm::vec3 normal = glm::normalize(calc_triangle_normal(get_particle(x + 1, y), get_particle(x, y), get_particle(x, y + 1)));
-            get_particle(x + 1, y)->add_to_normal(normal);
-            get_particle(x, y)->add_to_normal(normal);
-            get_particle(x, y + 1)->add_to_normal(normal);
-            vertex_normal_buffer.emplace_back(get_particle(x + 1, y)->get_normal());
-            vertex_normal_buffer.emplace_back(get_particle(x, y)->get_normal());
-            vertex_normal_buffer.emplace_back(get_particle(x, y + 1)->get_normal());
-//            vertex_tex_buffer.emplace_back(glm::font_vec2((float)x/m_width, (float)y/m_height));
+Cloth::~Cloth() = default;
 
-            vertex_position_buffer.emplace_back(get_particle(x + 1, y + 1)->get_position());
-            vertex_position_buffer.emplace_back(get_particle(x + 1, y)->get_position());
-            vertex_position_buffer.emplace_back(get_particle(x, y + 1)->get_position());
-            normal = glm::normalize(calc_triangle_normal(get_particle(x + 1, y + 1), get_particle(x + 1, y), get_particle(x, y + 1)));
-            get_particle(x + 1, y + 1)->add_to_normal(normal);
-            get_particle(x + 1, y)->add_to_normal(normal);
-            get_particle(x, y + 1)->add_to_normal(normal);
-            vertex_normal_buffer.emplace_back(get_particle(x + 1, y + 1)->get_normal());
-            vertex_normal_buffer.emplace_back(get_particle(x + 1, y)->get_normal());
-            vertex_normal_buffer.emplace_back(get_particle(x, y + 1)->get_normal());
-        }
-    }
+void Cloth::rebuild_vertex_buffer() {
+    m_mesh.update(get_particle_positions());
+}
 
-    return {vertex_position_buffer, vertex_normal_buffer, vertex_tex_buffer};
+void Cloth::set_compact_vertices(bool compact) {
+    m_mesh.set_compact_vertices(compact);
 }
 
-void Cloth::rebuild_vertex_buffer(bool first_invoked) {
-    const auto& [positions, normals, texcoords] = make_data_buffer();
+std::tuple<glm::vec3, glm::vec3> Cloth::get_position_decode() const {
+    return m_mesh.get_position_decode();
+}
 
-    if (first_invoked) {
-        glGenVertexArrays(1, &vao);
-        glGenBuffers(1, &vbo);
-        glGenBuffers(1, &vbo2);
+void Cloth::add_wind_force(const glm::vec3& direction) {
+    if (m_lod_level > 0) {
+        const LodLevel& level = m_lod_levels[m_lod_level - 1];
+        // a coarse triangle covers about stride^2 times the area of a fine one while its particles keep unit mass
+        glm::vec3 scaled_direction = direction / (float)(level.stride * level.stride);
+        for (int i = 0; i < level.xs.size() - 1; ++i) {
+            for (int j = 0; j < level.ys.size() - 1; ++j) {
+                int x0 = level.xs[i], x1 = level.xs[i + 1], y0 = level.ys[j], y1 = level.ys[j + 1];
+                add_wind_force_for_triangle(get_particle(x1, y0), get_particle(x0, y0), get_particle(x0, y1), scaled_direction);
+                add_wind_force_for_triangle(get_particle(x1, y1), get_particle(x1, y0), get_particle(x0, y1), scaled_direction);
+            }
+        }
+        return;
     }
 
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    if (first_invoked) {
-        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), &(positions.front()), GL_DYNAMIC_DRAW);
-    } else {
-        glBufferSubData(GL_ARRAY_BUFFER, 0, positions.size() * sizeof(glm::vec3), &(positions.front()));
+    for (int x = 0; x < m_width - 1; ++x) {
+        for (int y = 0; y < m_height - 1; ++y) {
+            add_wind_force_for_triangle(get_particle(x + 1, y), get_particle(x, y), get_particle(x, y + 1), direction);
+            add_wind_force_for_triangle(get_particle(x + 1, y + 1), get_particle(x + 1, y), get_particle(x, y + 1), direction);
+        }
     }
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo2);
-    if (first_invoked) {
-        glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), &(normals.front()), GL_DYNAMIC_DRAW);
+void Cloth::add_wind_force(const WindField& field) {
+    m_wind_triangles.clear();
+    auto add_cell = [&](int x0, int y0, int x1, int y1) {
+        Particle* triangles[6] = {get_particle(x1, y0), get_particle(x0, y0), get_particle(x0, y1),
+                                  get_particle(x1, y1), get_particle(x1, y0), get_particle(x0, y1)};
+        m_wind_triangles.insert(m_wind_triangles.end(), triangles, triangles + 6);
+    };
+
+    float scale = 1.f;
+    if (m_lod_level > 0) {
+        const LodLevel& level = m_lod_levels[m_lod_level - 1];
+        scale = 1.f / (float)(level.stride * level.stride);
+        for (int i = 0; i < level.xs.size() - 1; ++i) {
+            for (int j = 0; j < level.ys.size() - 1; ++j) {
+                add_cell(level.xs[i], level.ys[j], level.xs[i + 1], level.ys[j + 1]);
+            }
+        }
     } else {
-        glBufferSubData(GL_ARRAY_BUFFER, 0, normals.size() * sizeof(glm::vec3), &(normals.front()));
+        for (int x = 0; x < m_width - 1; ++x) {
+            for (int y = 0; y < m_height - 1; ++y) {
+                add_cell(x, y, x + 1, y + 1);
+            }
+        }
     }
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
-    glBindVertexArray(NULL);
 
-    if (!first_invoked) {
-        glBindVertexArray(vao);
-        glDrawArrays(GL_TRIANGLES, 0, positions.size());
-        glBindVertexArray(NULL);
+    // one batched lookup for every triangle centroid
+    size_t triangle_count = m_wind_triangles.size() / 3;
+    m_wind_positions.resize(triangle_count);
+    m_wind_samples.resize(triangle_count);
+    for (size_t i = 0; i < triangle_count; ++i) {
+        Particle** t = &m_wind_triangles[i * 3];
+        m_wind_positions[i] = (t[0]->get_position() + t[1]->get_position() + t[2]->get_position()) / 3.f;
     }
-}
+    field.sample(m_wind_positions.data(), m_wind_samples.data(), triangle_count);
 
-void Cloth::add_wind_force(const glm::vec3& direction) {
-    for (int x = 0; x < m_width - 1; ++x) {
-        for (int y = 0; y < m_height - 1; ++y) {
-            add_wind_force_for_triangle(get_particle(x + 1, y), get_particle(x, y), get_particle(x, y + 1), direction);
-            add_wind_force_for_triangle(get_particle(x + 1, y + 1), get_particle(x + 1, y), get_particle(x, y + 1), direction);
-        }
+    for (size_t i = 0; i < triangle_count; ++i) {
+        Particle** t = &m_wind_triangles[i * 3];
+        add_wind_force_for_triangle(t[0], t[1], t[2], m_wind_samples[i] * scale);
     }
 }
 
@@ -206,16 +220,50 @@ void Cloth::add_wind_force_for_triangle(Particle* p1, Particle* p2, Particle* p3
 }
 
 void Cloth::render() {
-    rebuild_vertex_buffer(false);
+    rebuild_vertex_buffer();
+    draw();
+}
+
+void Cloth::draw() {
+    m_mesh.draw();
+}
+
+unsigned int Cloth::get_vao() const {
+    return m_mesh.get_vao();
+}
+
+int Cloth::get_vertex_count() const {
+    return m_mesh.get_vertex_count();
 }
 
 void Cloth::update(float dt) {
     if (!m_enabled) return;
 
+    if (m_lod_level > 0) {
+        LodLevel& level = m_lod_levels[m_lod_level - 1];
+        for (int i = 0; i < constraint_iterations; i++) {
+            for (auto& constraint : level.constraints) {
+                constraint.satisfy();
+            }
+            satisfy_attachment();
+        }
+
+        for (int idx : level.active) {
+            Particle& p = m_particles[idx];
+            if (m_use_gravity) {
+                p.add_force(gravity_dir * dt);
+            }
+            p.update(dt);
+        }
+        upsample();
+        return;
+    }
+
     for (int i = 0; i < constraint_iterations; i++) {
         for (auto& constraint : m_constraint) {
             constraint.satisfy();
         }
+        satisfy_attachment();
     }
 
     for (auto& p : m_particles) {
@@ -226,16 +274,244 @@ void Cloth::update(float dt) {
     }
 }
 
-void Cloth::collision_detection_with_sphere(const glm::vec3& center, const float radius) {
+void Cloth::continuous_collision_with_sphere(const glm::vec3& prev_center, const glm::vec3& center, const float radius) {
     for (auto& p : m_particles) {
-        glm::vec3 distance = p.get_position() - center;
-        float length = glm::length(distance);
+        p.offset_pos(sphere_collision_offset(p.get_old_position(), p.get_position(), prev_center, center, radius));
+    }
+}
+
+glm::vec3 Cloth::sphere_collision_offset(const glm::vec3& old_position, const glm::vec3& position,
+                                         const glm::vec3& prev_center, const glm::vec3& center, const float radius) {
+    // sweep the particle's verlet step in the sphere's frame, so a moving sphere is a static one
+    glm::vec3 start = old_position - prev_center;
+    glm::vec3 end = position - center;
+    glm::vec3 motion = end - start;
+
+    float c = glm::dot(start, start) - radius * radius;
+    if (c <= 0.f) {
+        // already inside at the beginning of the step, push out along the radius
+        float length = glm::length(end);
         if (length < radius) {
-            p.offset_pos(glm::normalize(distance) * (radius - length));
+            return glm::normalize(end) * (radius - length);
         }
+        return glm::vec3(0.f);
     }
+
+    float a = glm::dot(motion, motion);
+    float b = 2.f * glm::dot(start, motion);
+    float discriminant = b * b - 4.f * a * c;
+    if (a <= 0.f || discriminant < 0.f) return glm::vec3(0.f);
+
+    float t = (-b - glm::sqrt(discriminant)) / (2.f * a);
+    if (t < 0.f || t > 1.f) return glm::vec3(0.f);
+
+    // remove only the motion into the sphere after the first contact: the end point is projected along the
+    // contact normal onto the tangent plane there, the tangential part is kept so the cloth can slide off
+    glm::vec3 normal = glm::normalize(start + motion * t);
+    float depth = radius - glm::dot(end, normal);
+    return depth > 0.f ? normal * depth : glm::vec3(0.f);
 }
 
 Particle* Cloth::get_particle(int x, int y) {
     return &m_particles[y * m_width + x];
+}
+
+void Cloth::set_positions(const std::vector<glm::vec3>& positions) {
+    for (int i = 0; i < m_particles.size() && i < positions.size(); ++i) {
+        m_particles[i].set_state(positions[i], positions[i]);
+    }
+}
+
+std::tuple<glm::vec3, glm::vec3> Cloth::get_bounds() const {
+    glm::vec3 min = m_particles.front().get_position(), max = min;
+    for (const auto& p : m_particles) {
+        min = glm::min(min, p.get_position());
+        max = glm::max(max, p.get_position());
+    }
+    return {min, max};
+}
+
+int Cloth::get_particle_count() const {
+    return m_particles.size();
+}
+
+void Cloth::get_constraint_topology(std::vector<glm::uvec2>& out_particles, std::vector<float>& out_rest_distances) const {
+    out_particles.resize(m_constraint.size());
+    out_rest_distances.resize(m_constraint.size());
+    for (int i = 0; i < m_constraint.size(); ++i) {
+        out_particles[i] = glm::uvec2(m_constraint[i].get_first() - m_particles.data(), m_constraint[i].get_second() - m_particles.data());
+        out_rest_distances[i] = m_constraint[i].get_rest_distance();
+    }
+}
+
+void Cloth::write_particle_state(glm::vec4* out) const {
+    for (int i = 0; i < m_particles.size(); ++i) {
+        const Particle& p = m_particles[i];
+        float moved = p.is_movable() ? glm::length(p.get_position() - p.get_old_position()) : -1.f;
+        out[i] = glm::vec4(p.get_position(), moved);
+    }
+}
+
+void Cloth::refit_bvh() {
+    m_bvh.refit(get_particle_positions());
+}
+
+PositionView Cloth::get_particle_positions() const {
+    return PositionView(&m_particles[0].get_position(), sizeof(Particle));
+}
+
+bool Cloth::raycast(const glm::vec3& origin, const glm::vec3& direction, float& out_t, int& out_particle) {
+    // the tree is refit at the end of every step, a pick is only the traversal
+    RayHit hit{};
+    if (!m_bvh.raycast(origin, direction, get_particle_positions(), hit)) return false;
+
+    // closest vertex of the hit triangle
+    const glm::uvec3& triangle = m_bvh.get_triangle(hit.triangle);
+    float w = 1.f - hit.u - hit.v;
+    out_particle = w >= hit.u && w >= hit.v ? triangle.x : (hit.u >= hit.v ? triangle.y : triangle.z);
+    out_t = hit.t;
+    return true;
+}
+
+void Cloth::attach(int particle, const glm::vec3& target) {
+    m_attached_particle = particle;
+    m_attachment_target = target;
+}
+
+void Cloth::move_attachment(const glm::vec3& target) {
+    m_attachment_target = target;
+}
+
+void Cloth::release_attachment() {
+    m_attached_particle = -1;
+}
+
+bool Cloth::has_attachment() const {
+    return m_attached_particle >= 0;
+}
+
+void Cloth::satisfy_attachment() {
+    if (m_attached_particle < 0) return;
+    Particle& p = m_particles[m_attached_particle];
+    p.offset_pos(m_attachment_target - p.get_position());
+}
+
+void Cloth::set_lod_level(int level) {
+    level = glm::clamp(level, 0, (int)m_lod_levels.size());
+    if (level == m_lod_level) return;
+
+    // every coarse lattice is a subset of the finer ones and the particles in between follow the lattice.
+    // What the new lattice can't represent is kept as a detail offset on top of the interpolation, so switching
+    // moves no particle and the fine detail is still there when a finer level takes over again.
+    m_lod_level = level;
+    if (m_lod_level > 0) {
+        capture_lod_detail();
+    }
+}
+
+int Cloth::get_lod_level() const {
+    return m_lod_level;
+}
+
+int Cloth::get_constraint_count() const {
+    if (m_lod_level > 0)
+        return m_lod_levels[m_lod_level - 1].constraints.size();
+    return m_constraint.size();
+}
+
+void Cloth::build_lod_level(int stride) {
+    LodLevel level{};
+    level.stride = stride;
+    for (int x = 0; x < m_width; x += stride) level.xs.push_back(x);
+    if (level.xs.back() != m_width - 1) level.xs.push_back(m_width - 1);
+    for (int y = 0; y < m_height; y += stride) level.ys.push_back(y);
+    if (level.ys.back() != m_height - 1) level.ys.push_back(m_height - 1);
+    if (level.xs.size() < 3 || level.ys.size() < 3) return; // too small to decimate
+
+    int lattice_w = level.xs.size(), lattice_h = level.ys.size();
+    level.x_span.resize(m_width);
+    for (int i = 0; i < lattice_w - 1; ++i) {
+        for (int x = level.xs[i]; x <= level.xs[i + 1]; ++x) level.x_span[x] = i;
+    }
+    level.y_span.resize(m_height);
+    for (int j = 0; j < lattice_h - 1; ++j) {
+        for (int y = level.ys[j]; y <= level.ys[j + 1]; ++y) level.y_span[y] = j;
+    }
+
+    for (int y : level.ys) {
+        for (int x : level.xs) {
+            level.active.push_back(y * m_width + x);
+        }
+    }
+
+    auto lattice = [&](int i, int j) { return get_particle(level.xs[i], level.ys[j]); };
+
+    // same connectivity as the full grid, on lattice coordinates
+    for (int i = 0; i < lattice_w; ++i) {
+        for (int j = 0; j < lattice_h; ++j) {
+            if (i < lattice_w - 1) level.constraints.emplace_back(Constraint(lattice(i, j), lattice(i + 1, j)));
+            if (j < lattice_h - 1) level.constraints.emplace_back(Constraint(lattice(i, j), lattice(i, j + 1)));
+            if (i < lattice_w - 1 && j < lattice_h - 1) {
+                level.constraints.emplace_back(Constraint(lattice(i, j), lattice(i + 1, j + 1)));
+                level.constraints.emplace_back(Constraint(lattice(i + 1, j), lattice(i, j + 1)));
+            }
+        }
+    }
+
+    for (int i = 0; i < lattice_w; ++i) {
+        for (int j = 0; j < lattice_h; ++j) {
+            if (i < lattice_w - 2) level.constraints.emplace_back(Constraint(lattice(i, j), lattice(i + 2, j)));
+            if (j < lattice_h - 2) level.constraints.emplace_back(Constraint(lattice(i, j), lattice(i, j + 2)));
+            if (i < lattice_w - 2 && j < lattice_h - 2) {
+                level.constraints.emplace_back(Constraint(lattice(i, j), lattice(i + 2, j + 2)));
+                level.constraints.emplace_back(Constraint(lattice(i + 2, j), lattice(i, j + 2)));
+            }
+        }
+    }
+
+    m_lod_levels.emplace_back(std::move(level));
+}
+
+std::tuple<glm::vec3, glm::vec3> Cloth::interpolate_lattice(const LodLevel& level, int x, int y) {
+    int i = level.x_span[x], j = level.y_span[y];
+    int x0 = level.xs[i], x1 = level.xs[i + 1];
+    int y0 = level.ys[j], y1 = level.ys[j + 1];
+    float tx = (x - x0) / (float)(x1 - x0), ty = (y - y0) / (float)(y1 - y0);
+    Particle* p00 = get_particle(x0, y0), *p10 = get_particle(x1, y0);
+    Particle* p01 = get_particle(x0, y1), *p11 = get_particle(x1, y1);
+    glm::vec3 position = glm::mix(glm::mix(p00->get_position(), p10->get_position(), tx),
+                                  glm::mix(p01->get_position(), p11->get_position(), tx), ty);
+    glm::vec3 old_position = glm::mix(glm::mix(p00->get_old_position(), p10->get_old_position(), tx),
+                                      glm::mix(p01->get_old_position(), p11->get_old_position(), tx), ty);
+    return {position, old_position};
+}
+
+bool Cloth::is_lattice_particle(const LodLevel& level, int x, int y) const {
+    int i = level.x_span[x], j = level.y_span[y];
+    return (x == level.xs[i] || x == level.xs[i + 1]) && (y == level.ys[j] || y == level.ys[j + 1]);
+}
+
+void Cloth::capture_lod_detail() {
+    const LodLevel& level = m_lod_levels[m_lod_level - 1];
+    m_lod_detail.assign(m_particles.size(), glm::vec3(0.f));
+    for (int y = 0; y < m_height; ++y) {
+        for (int x = 0; x < m_width; ++x) {
+            if (is_lattice_particle(level, x, y)) continue;
+            m_lod_detail[y * m_width + x] = get_particle(x, y)->get_position() - std::get<0>(interpolate_lattice(level, x, y));
+        }
+    }
+}
+
+void Cloth::upsample() {
+    const LodLevel& level = m_lod_levels[m_lod_level - 1];
+    for (int y = 0; y < m_height; ++y) {
+        for (int x = 0; x < m_width; ++x) {
+            if (is_lattice_particle(level, x, y)) continue; // simulated
+
+            // the detail rides along with the lattice, the particle moves with the interpolated velocity
+            const auto& [position, old_position] = interpolate_lattice(level, x, y);
+            const glm::vec3& detail = m_lod_detail[y * m_width + x];
+            get_particle(x, y)->set_state(position + detail, old_position + detail);
+        }
+    }
 }
\ No newline at end of file
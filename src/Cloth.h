@@ -4,25 +4,30 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <tuple>
+#include <cstdint>
+#include "BVH.h"
+#include "ClothMesh.h"
+
+class WindField;
 
 class Particle {
 public:
   Particle() = default;
   explicit Particle(const glm::vec3& position);
 
-  glm::vec3 get_position() const;
-  glm::vec3& get_normal();
-  void add_to_normal(glm::vec3& normal);
-  void reset_normal();
+  const glm::vec3& get_position() const;
+  glm::vec3 get_old_position() const;
+  bool is_movable() const;
 
   void offset_pos(const glm::vec3& v);
+  void set_state(const glm::vec3& position, const glm::vec3& old_position);
   void set_movable(bool movable);
 
   void add_force(const glm::vec3& force);
   void update(float dt);
 
 private:
-  glm::vec3 m_position{}, m_old_position{}, m_acceleration = glm::vec3(0, 0, 0), m_accumulated_normal = glm::vec3(0, 0, 0);
+  glm::vec3 m_position{}, m_old_position{}, m_acceleration = glm::vec3(0, 0, 0);
   float m_mass = 1.f, m_damping = 0.01f;
   bool m_is_movable = true;
 };
@@ -31,30 +36,76 @@ class Constraint {
 public:
   Constraint(Particle* p1, Particle* p2);
   void satisfy();
+  const Particle* get_first() const;
+  const Particle* get_second() const;
+  float get_rest_distance() const;
 
 private:
   float m_rest_distance;
   Particle* m_p1, *m_p2;
 };
 
+// decimated simulation lattice, every coarse particle is also a particle of the full render grid
+struct LodLevel {
+  int stride;
+  std::vector<int> xs, ys; // full grid coordinates of the lattice columns and rows
+  std::vector<int> x_span, y_span; // for every full grid coordinate, index of the lattice cell that contains it
+  std::vector<int> active; // particle indices simulated on this level
+  std::vector<Constraint> constraints;
+};
+
 class Cloth {
 public:
   Cloth(int w, int h);
   ~Cloth();
 
-  std::tuple<std::vector<glm::vec3>, std::vector<glm::vec3>, std::vector<glm::vec2>> make_data_buffer();
-  void rebuild_vertex_buffer(bool first_invoked);
+  void rebuild_vertex_buffer();
+  void set_compact_vertices(bool compact);
+  std::tuple<glm::vec3, glm::vec3> get_position_decode() const; // offset and scale of the uploaded positions
   void add_wind_force(const glm::vec3& direction);
+  void add_wind_force(const WindField& field);
 
   void render();
+  void draw();
+  unsigned int get_vao() const;
+  int get_vertex_count() const;
   void update(float dt);
-  void collision_detection_with_sphere(const glm::vec3& center, float radius);
+  void continuous_collision_with_sphere(const glm::vec3& prev_center, const glm::vec3& center, float radius);
+  // correction of one particle's step against a sphere moving over the same step, shared with DistributedCloth
+  static glm::vec3 sphere_collision_offset(const glm::vec3& old_position, const glm::vec3& position,
+                                           const glm::vec3& prev_center, const glm::vec3& center, float radius);
 
   Particle* get_particle(int x, int y);
+  void set_positions(const std::vector<glm::vec3>& positions);
+  std::tuple<glm::vec3, glm::vec3> get_bounds() const;
+
+  // debug overlay, constraints as particle index pairs of the full grid
+  int get_particle_count() const;
+  void get_constraint_topology(std::vector<glm::uvec2>& out_particles, std::vector<float>& out_rest_distances) const;
+  void write_particle_state(glm::vec4* out) const; // xyz position, w distance moved in the last step, -1 if pinned
+
+  void refit_bvh(); // at the end of a simulation step, once collisions have moved the particles
+  PositionView get_particle_positions() const; // positions of m_particles in place
+  bool raycast(const glm::vec3& origin, const glm::vec3& direction, float& out_t, int& out_particle);
+  void attach(int particle, const glm::vec3& target);
+  void move_attachment(const glm::vec3& target);
+  void release_attachment();
+  bool has_attachment() const;
+
+  void set_lod_level(int level);
+  int get_lod_level() const;
+  int get_constraint_count() const; // constraints solved on the current level
+  static constexpr int max_lod_level = 2;
 
 private:
   glm::vec3 calc_triangle_normal(Particle* p1, Particle* p2, Particle* p3) const;
   void add_wind_force_for_triangle(Particle* p1, Particle* p2, Particle* p3, const glm::vec3& direction);
+  void build_lod_level(int stride);
+  std::tuple<glm::vec3, glm::vec3> interpolate_lattice(const LodLevel& level, int x, int y); // position, old position
+  bool is_lattice_particle(const LodLevel& level, int x, int y) const;
+  void capture_lod_detail();
+  void upsample();
+  void satisfy_attachment();
 
 private:
   int m_width, m_height;
@@ -62,7 +113,15 @@ private:
   int constraint_iterations = 15;
   std::vector<Particle> m_particles;
   std::vector<Constraint> m_constraint;
-  unsigned int vao = 0, vbo = 0, vbo2 = 0;
+  std::vector<LodLevel> m_lod_levels; // index 0 is stride 2, the full grid uses m_constraint
+  int m_lod_level = 0;
+  std::vector<glm::vec3> m_lod_detail; // per particle offset from the lattice interpolation, kept while coarse
+  BVH m_bvh; // picking, built with the cloth and refit once per step
+  int m_attached_particle = -1;
+  glm::vec3 m_attachment_target{};
+  std::vector<Particle*> m_wind_triangles; // scratch buffers of the wind field pass
+  std::vector<glm::vec3> m_wind_positions, m_wind_samples;
+  ClothMesh m_mesh;
   static glm::vec3 gravity_dir;
 };
 
@@ -0,0 +1,131 @@
+#include "ClothMesh.h"
+#include "VertexPacking.h"
+#include <GL/glew.h>
+#include <algorithm>
+
+ClothMesh::ClothMesh(int w, int h) : m_width{w}, m_height{h} {
+    m_positions.reserve(6 * m_width * m_height);
+    m_normals.reserve(6 * m_width * m_height);
+    m_accumulated_normals.resize(m_width * m_height);
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &vbo2);
+}
+
+ClothMesh::~ClothMesh() {
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &vbo2);
+}
+
+void ClothMesh::make_data_buffer(const PositionView& positions) {
+    m_positions.clear();
+    m_normals.clear();
+    std::fill(m_accumulated_normals.begin(), m_accumulated_normals.end(), glm::vec3(0.f));
+
+    auto add_triangle = [&](int a, int b, int c) {
+        m_positions.emplace_back(positions[a]);
+        m_positions.emplace_back(positions[b]);
+        m_positions.emplace_back(positions[c]);
+        glm::vec3 normal = glm::normalize(glm::cross(positions[b] - positions[a], positions[c] - positions[a]));
+        m_accumulated_normals[a] += normal;
+        m_accumulated_normals[b] += normal;
+        m_accumulated_normals[c] += normal;
+        m_normals.emplace_back(m_accumulated_normals[a]);
+        m_normals.emplace_back(m_accumulated_normals[b]);
+        m_normals.emplace_back(m_accumulated_normals[c]);
+    };
+    for (int x = 0; x < m_width - 1; x++) {
+        for (int y = 0; y < m_height - 1; y++) {
+            add_triangle(y * m_width + x + 1, y * m_width + x, (y + 1) * m_width + x);
+            add_triangle((y + 1) * m_width + x + 1, y * m_width + x + 1, (y + 1) * m_width + x);
+        }
+    }
+}
+
+void ClothMesh::update(const PositionView& positions) {
+    make_data_buffer(positions);
+
+    // switching formats changes the buffer sizes
+    bool allocate = !m_allocated || m_allocated_compact != m_compact_vertices;
+    m_allocated = true;
+    m_allocated_compact = m_compact_vertices;
+
+    glBindVertexArray(vao);
+    if (m_compact_vertices) {
+        // 16 bit positions against the bounding box and 10 bit normals, 12 bytes per vertex instead of 24
+        glm::vec3 min = positions[0], max = min;
+        for (int i = 0; i < m_width * m_height; ++i) {
+            min = glm::min(min, positions[i]);
+            max = glm::max(max, positions[i]);
+        }
+        m_decode_offset = min;
+        m_decode_scale = glm::max(max - min, glm::vec3(1e-6f));
+        m_packed_positions.resize(m_positions.size() * 4);
+        m_packed_normals.resize(m_normals.size());
+        pack_positions_unorm16(m_positions.data(), m_positions.size(), min, max, m_packed_positions.data());
+        pack_normals_snorm10(m_normals.data(), m_normals.size(), m_packed_normals.data());
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (allocate) {
+            glBufferData(GL_ARRAY_BUFFER, m_packed_positions.size() * sizeof(uint16_t), m_packed_positions.data(), GL_DYNAMIC_DRAW);
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, m_packed_positions.size() * sizeof(uint16_t), m_packed_positions.data());
+        }
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, 4 * sizeof(uint16_t), (void *)0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo2);
+        if (allocate) {
+            glBufferData(GL_ARRAY_BUFFER, m_packed_normals.size() * sizeof(uint32_t), m_packed_normals.data(), GL_DYNAMIC_DRAW);
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, m_packed_normals.size() * sizeof(uint32_t), m_packed_normals.data());
+        }
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(uint32_t), (void *)0);
+    } else {
+        m_decode_offset = glm::vec3(0.f);
+        m_decode_scale = glm::vec3(1.f);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (allocate) {
+            glBufferData(GL_ARRAY_BUFFER, m_positions.size() * sizeof(glm::vec3), m_positions.data(), GL_DYNAMIC_DRAW);
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, m_positions.size() * sizeof(glm::vec3), m_positions.data());
+        }
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo2);
+        if (allocate) {
+            glBufferData(GL_ARRAY_BUFFER, m_normals.size() * sizeof(glm::vec3), m_normals.data(), GL_DYNAMIC_DRAW);
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, m_normals.size() * sizeof(glm::vec3), m_normals.data());
+        }
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+    }
+    glBindVertexArray(NULL);
+}
+
+void ClothMesh::set_compact_vertices(bool compact) {
+    m_compact_vertices = compact;
+}
+
+std::tuple<glm::vec3, glm::vec3> ClothMesh::get_position_decode() const {
+    return {m_decode_offset, m_decode_scale};
+}
+
+unsigned int ClothMesh::get_vao() const {
+    return vao;
+}
+
+int ClothMesh::get_vertex_count() const {
+    return m_positions.size();
+}
+
+void ClothMesh::draw() {
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, get_vertex_count());
+    glBindVertexArray(NULL);
+}
@@ -0,0 +1,38 @@
+#ifndef CLOTH_SIMULATION_CLOTHMESH_H
+#define CLOTH_SIMULATION_CLOTHMESH_H
+
+#include "BVH.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+// Render mesh of a width x height particle grid, two triangles per cell with normals accumulated from the faces.
+// It only reads positions, so Cloth and the shared memory of DistributedCloth are drawn the same way.
+class ClothMesh {
+public:
+  ClothMesh(int w, int h);
+  ~ClothMesh();
+
+  void update(const PositionView& positions); // rebuilds and uploads the vertices
+  void set_compact_vertices(bool compact);
+  std::tuple<glm::vec3, glm::vec3> get_position_decode() const; // offset and scale of the uploaded positions
+  unsigned int get_vao() const;
+  int get_vertex_count() const;
+  void draw();
+
+private:
+  void make_data_buffer(const PositionView& positions);
+
+private:
+  int m_width, m_height;
+  std::vector<glm::vec3> m_positions, m_normals; // per vertex, three per triangle
+  std::vector<glm::vec3> m_accumulated_normals; // per particle
+  unsigned int vao = 0, vbo = 0, vbo2 = 0;
+  bool m_compact_vertices = false, m_allocated = false, m_allocated_compact = false;
+  glm::vec3 m_decode_offset = glm::vec3(0.f), m_decode_scale = glm::vec3(1.f);
+  std::vector<uint16_t> m_packed_positions;
+  std::vector<uint32_t> m_packed_normals;
+};
+
+#endif //CLOTH_SIMULATION_CLOTHMESH_H
@@ -0,0 +1,200 @@
+#include "DebugOverlay.h"
+#include "Cloth.h"
+#include "utils.h"
+#include <GL/glew.h>
+#include <cstddef>
+#include <vector>
+
+DebugOverlay::~DebugOverlay() {
+    for (void*& fence : m_fences) {
+        if (fence) glDeleteSync((GLsync)fence);
+        fence = nullptr;
+    }
+    if (m_persistent_data) {
+        glBindBuffer(GL_TEXTURE_BUFFER, ring_buffer);
+        glUnmapBuffer(GL_TEXTURE_BUFFER);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+    glDeleteTextures(1, &ring_texture);
+    glDeleteBuffers(1, &ring_buffer);
+    glDeleteBuffers(1, &topology_vbo);
+    glDeleteVertexArrays(1, &line_vao);
+    glDeleteVertexArrays(1, &point_vao);
+    glDeleteProgram(line_shader.id);
+    glDeleteProgram(point_shader.id);
+}
+
+bool DebugOverlay::init(Renderer& renderer) {
+    if (!renderer.load_program(line_shader, "../shaders/debug_line_vs.glsl", "../shaders/axis_fs.glsl"))
+        return false;
+    if (!renderer.load_program(point_shader, "../shaders/debug_point_vs.glsl", "../shaders/axis_fs.glsl"))
+        return false;
+    line_particle_base = glGetUniformLocation(line_shader.id, "particleBase");
+    line_strain_scale = glGetUniformLocation(line_shader.id, "strainScale");
+    point_particle_base = glGetUniformLocation(point_shader.id, "particleBase");
+    point_speed_scale = glGetUniformLocation(point_shader.id, "speedScale");
+
+    // persistent mapping needs GL 4.4 or ARB_buffer_storage, otherwise each section is mapped unsynchronized
+    m_persistent = GLEW_ARB_buffer_storage;
+
+    glGenVertexArrays(1, &line_vao);
+    glGenVertexArrays(1, &point_vao);
+    glGenBuffers(1, &topology_vbo);
+    glGenBuffers(1, &ring_buffer);
+    glGenTextures(1, &ring_texture);
+    return true;
+}
+
+void DebugOverlay::upload_topology(const Cloth& cloth) {
+    std::vector<glm::uvec2> particles;
+    std::vector<float> rest_distances;
+    cloth.get_constraint_topology(particles, rest_distances);
+    m_constraint_count = particles.size();
+
+    struct Instance {
+      glm::uvec2 particles;
+      float rest_distance;
+    };
+    std::vector<Instance> instances(m_constraint_count);
+    for (int i = 0; i < m_constraint_count; ++i) {
+        instances[i] = {particles[i], rest_distances[i]};
+    }
+
+    // one instance per constraint, the two line vertices pick their end by gl_VertexID
+    glBindVertexArray(line_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, topology_vbo);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Instance), instances.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribIPointer(0, 2, GL_UNSIGNED_INT, sizeof(Instance), (void *)0);
+    glVertexAttribDivisor(0, 1);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), (void *)offsetof(Instance, rest_distance));
+    glVertexAttribDivisor(1, 1);
+    glBindVertexArray(NULL);
+}
+
+bool DebugOverlay::reserve_ring(int particle_count) {
+    if (particle_count <= m_section_capacity)
+        return true;
+
+    int max_texels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+    if ((long long)particle_count * ring_sections > max_texels) {
+        error("debug overlay: too many particles for a texture buffer");
+        return false;
+    }
+
+    // the old storage may still be read by queued draws, wait for them before replacing it
+    for (void*& fence : m_fences) {
+        if (fence) {
+            glClientWaitSync((GLsync)fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync((GLsync)fence);
+            fence = nullptr;
+        }
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, ring_buffer);
+    if (m_persistent_data) {
+        glUnmapBuffer(GL_TEXTURE_BUFFER);
+        m_persistent_data = nullptr;
+    }
+    size_t size = (size_t)particle_count * ring_sections * sizeof(glm::vec4);
+    if (m_persistent) {
+        // immutable storage can't be resized, start over with a new buffer
+        glDeleteBuffers(1, &ring_buffer);
+        glGenBuffers(1, &ring_buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, ring_buffer);
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_TEXTURE_BUFFER, size, nullptr, flags);
+        m_persistent_data = (glm::vec4*)glMapBufferRange(GL_TEXTURE_BUFFER, 0, size, flags);
+        if (!m_persistent_data) {
+            error("debug overlay: persistent mapping failed");
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+            return false;
+        }
+    } else {
+        glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, ring_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, ring_buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    m_section_capacity = particle_count;
+    m_section = 0;
+    return true;
+}
+
+glm::vec4* DebugOverlay::begin_section() {
+    // only blocks when the GPU is still drawing from this section, ring_sections frames ago
+    void*& fence = m_fences[m_section];
+    if (fence) {
+        glClientWaitSync((GLsync)fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync((GLsync)fence);
+        fence = nullptr;
+    }
+
+    if (m_persistent)
+        return m_persistent_data + (size_t)m_section * m_section_capacity;
+
+    size_t section_size = (size_t)m_section_capacity * sizeof(glm::vec4);
+    glBindBuffer(GL_TEXTURE_BUFFER, ring_buffer);
+    // the fence already guarantees the section is free, so the driver needn't synchronize
+    return (glm::vec4*)glMapBufferRange(GL_TEXTURE_BUFFER, m_section * section_size, section_size,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+void DebugOverlay::end_section() {
+    if (!m_persistent) {
+        glUnmapBuffer(GL_TEXTURE_BUFFER);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+}
+
+void DebugOverlay::draw(const Cloth& cloth, const glm::mat4& model, bool show_constraints, bool show_particles) {
+    if (!show_constraints && !show_particles)
+        return;
+
+    int particle_count = cloth.get_particle_count();
+    if (!reserve_ring(particle_count))
+        return;
+    glm::vec4* section = begin_section();
+    if (!section)
+        return;
+    cloth.write_particle_state(section);
+    end_section();
+    int particle_base = m_section * m_section_capacity;
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, ring_texture);
+    glDisable(GL_DEPTH_TEST);
+
+    if (show_constraints) {
+        if (m_constraint_count == 0)
+            upload_topology(cloth);
+        glUseProgram(line_shader.id);
+        glUniformMatrix4fv(line_shader.model, 1, GL_FALSE, glm::value_ptr(model));
+        glUniform1i(line_particle_base, particle_base);
+        glUniform1f(line_strain_scale, strain_scale);
+        glBindVertexArray(line_vao);
+        glDrawArraysInstanced(GL_LINES, 0, 2, m_constraint_count);
+    }
+
+    if (show_particles) {
+        glUseProgram(point_shader.id);
+        glUniformMatrix4fv(point_shader.model, 1, GL_FALSE, glm::value_ptr(model));
+        glUniform1i(point_particle_base, particle_base);
+        glUniform1f(point_speed_scale, speed_scale);
+        glPointSize(3.f);
+        // attributeless, the instance id selects the particle
+        glBindVertexArray(point_vao);
+        glDrawArraysInstanced(GL_POINTS, 0, 1, particle_count);
+    }
+
+    glBindVertexArray(NULL);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glEnable(GL_DEPTH_TEST);
+
+    m_fences[m_section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_section = (m_section + 1) % ring_sections;
+}
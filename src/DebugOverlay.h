@@ -0,0 +1,45 @@
+#ifndef CLOTH_SIMULATION_DEBUGOVERLAY_H
+#define CLOTH_SIMULATION_DEBUGOVERLAY_H
+
+#include "Renderer.h"
+#include <glm/gtc/type_ptr.hpp>
+
+class Cloth;
+
+// Draws every cloth constraint as a line colored by strain (blue compressed, green at rest, red stretched)
+// and optionally every particle as a point colored by speed, pinned ones magenta.
+// Constraint topology is uploaded once, per frame only the particle state streams through a ring of
+// buffer sections read as a texture buffer, so each layer is a single instanced draw.
+class DebugOverlay {
+public:
+  DebugOverlay() = default;
+  ~DebugOverlay();
+
+  bool init(Renderer& renderer);
+  void draw(const Cloth& cloth, const glm::mat4& model, bool show_constraints, bool show_particles);
+
+  float strain_scale = 0.1f; // strain drawn at full color
+  float speed_scale = 0.01f; // distance per step drawn at full color
+
+private:
+  void upload_topology(const Cloth& cloth);
+  bool reserve_ring(int particle_count);
+  glm::vec4* begin_section();
+  void end_section();
+
+private:
+  static constexpr int ring_sections = 3;
+  ShaderProgram line_shader, point_shader;
+  int line_particle_base = -1, line_strain_scale = -1, point_particle_base = -1, point_speed_scale = -1;
+
+  unsigned int line_vao = 0, point_vao = 0, topology_vbo = 0;
+  int m_constraint_count = 0;
+
+  unsigned int ring_buffer = 0, ring_texture = 0;
+  int m_section_capacity = 0, m_section = 0; // capacity in particles
+  bool m_persistent = false;
+  glm::vec4* m_persistent_data = nullptr;
+  void* m_fences[ring_sections] = {}; // GLsync of the last draw reading each section
+};
+
+#endif //CLOTH_SIMULATION_DEBUGOVERLAY_H
@@ -0,0 +1,487 @@
+#include "DistributedCloth.h"
+#include "Cloth.h"
+#include "utils.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+struct alignas(64) DistributedCloth::Counter {
+  std::atomic<unsigned long long> value{0};
+};
+
+struct alignas(64) DistributedCloth::Header {
+  std::atomic<unsigned long long> step_request{0};
+  std::atomic<bool> quit{false};
+  pthread_mutex_t mutex; // process shared and robust, idle workers sleep on step_ready instead of spinning between steps
+  pthread_cond_t step_ready;
+  float dt = 0.f, sphere_radius = 0.f;
+  glm::vec3 wind_dir{}, sphere_prev_center{}, sphere_center{};
+};
+
+static_assert(std::atomic<unsigned long long>::is_always_lock_free, "counters are shared between processes");
+static_assert(std::atomic<bool>::is_always_lock_free, "flags are shared between processes");
+
+namespace {
+  // same material as Cloth
+  const glm::vec3 gravity_dir = glm::vec3(0.f, -0.2f, 0.f);
+  const float damping = 0.01f;
+  // immediate and secondary neighbours, same connectivity as Cloth
+  const int constraint_offsets[8][2] = {{1, 0}, {0, 1}, {1, 1}, {-1, 1}, {2, 0}, {0, 2}, {2, 2}, {-2, 2}};
+
+  size_t align_up(size_t size) {
+      return (size + 63) & ~size_t(63);
+  }
+
+  // parses sysfs lists like "0-7,16-23", anything malformed gives an empty list so callers fall back
+  std::vector<int> parse_list(const std::string& list) {
+      std::vector<int> values{};
+      const char* cursor = list.c_str();
+      while (*cursor != '\0' && *cursor != '\n') {
+          char* end = nullptr;
+          long first = std::strtol(cursor, &end, 10);
+          if (end == cursor || first < 0) return {};
+          long last = first;
+          cursor = end;
+          if (*cursor == '-') {
+              last = std::strtol(cursor + 1, &end, 10);
+              if (end == cursor + 1 || last < first) return {};
+              cursor = end;
+          }
+          for (long i = first; i <= last; ++i) values.push_back((int)i);
+          if (*cursor == ',') {
+              ++cursor;
+          } else if (*cursor != '\0' && *cursor != '\n') {
+              return {};
+          }
+      }
+      return values;
+  }
+
+  std::vector<int> read_sysfs_list(const std::string& path) {
+      std::ifstream file(path);
+      std::string list{};
+      if (!file || !std::getline(file, list)) return {};
+      return parse_list(list);
+  }
+
+  int get_numa_node_count() {
+      std::vector<int> nodes = read_sysfs_list("/sys/devices/system/node/online");
+      return nodes.empty() ? 1 : (int)nodes.size();
+  }
+
+  void pin_to_numa_node(int node) {
+#ifdef __linux__
+      std::vector<int> cpus = read_sysfs_list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+      if (cpus.empty()) return;
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (int cpu : cpus) CPU_SET(cpu, &set);
+      if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+          error("failed to pin domain to numa node " + std::to_string(node));
+      }
+#endif
+  }
+
+  // false when another process died holding the mutex. it is locked and usable again then, but a process of the
+  // simulation is gone, so callers give up instead of waiting for it
+  bool lock_robust(pthread_mutex_t& mutex) {
+      int result = pthread_mutex_lock(&mutex);
+#ifdef __linux__
+      if (result == EOWNERDEAD) {
+          pthread_mutex_consistent(&mutex);
+          return false;
+      }
+#endif
+      return result == 0;
+  }
+
+  // same as lock_robust for the relock at the end of the wait
+  bool timed_wait_robust(pthread_cond_t& condition, pthread_mutex_t& mutex, const timespec& deadline) {
+      int result = pthread_cond_timedwait(&condition, &mutex, &deadline);
+#ifdef __linux__
+      if (result == EOWNERDEAD) {
+          pthread_mutex_consistent(&mutex);
+          return false;
+      }
+#endif
+      return true;
+  }
+
+  // spins until counter reaches value. stop() is polled every so often and ends the wait when the other side
+  // is gone or shutting down, false is returned then.
+  template <typename Stop>
+  bool wait_for(const std::atomic<unsigned long long>& counter, unsigned long long value, Stop&& stop) {
+      for (unsigned spins = 1; counter.load(std::memory_order_acquire) < value; ++spins) {
+          if (spins % 1024 == 0 && stop()) return false;
+          std::this_thread::yield();
+      }
+      return true;
+  }
+}
+
+DistributedCloth::DistributedCloth(int w, int h, int domain_count) : m_width{w}, m_height{h} {
+    // strips must be at least as tall as the halos on both sides, thinner ones are mostly boundary and do not converge
+    domain_count = glm::max(1, glm::min(domain_count, m_height / 4));
+    int node_count = get_numa_node_count();
+    int rows = m_height / domain_count, remainder = m_height % domain_count;
+    int y = 0;
+    for (int i = 0; i < domain_count; ++i) {
+        Domain domain{};
+        domain.y_begin = y;
+        y += rows + (i < remainder ? 1 : 0);
+        domain.y_end = y;
+        domain.numa_node = i * node_count / domain_count; // neighbouring strips share a node
+        domain.pid = 0;
+        m_domains.push_back(domain);
+    }
+}
+
+DistributedCloth::~DistributedCloth() {
+    if (m_header) {
+        stop_workers();
+    }
+    // the mutex and condition are not destroyed: a killed worker can stay registered as a waiter, which makes
+    // pthread_cond_destroy block. they live in the mapping and go away with it.
+    if (m_memory) {
+        munmap(m_memory, m_memory_size);
+    }
+}
+
+bool DistributedCloth::start() {
+    size_t domain_count = m_domains.size();
+    size_t header_size = align_up(sizeof(Header));
+    size_t counters_size = align_up(sizeof(Counter) * domain_count);
+    size_t positions_size = align_up(sizeof(glm::vec3) * m_width * m_height);
+    size_t halos_size = sizeof(glm::vec3) * domain_count * 2 * 4 * m_width;
+    m_memory_size = header_size + 2 * counters_size + positions_size + halos_size;
+
+    std::string name = "/cloth_simulation_" + std::to_string(getpid());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        error("shm_open failed for " + name);
+        return false;
+    }
+    if (ftruncate(fd, (off_t)m_memory_size) != 0) {
+        error("ftruncate failed for " + name);
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void* memory = mmap(nullptr, m_memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    // workers inherit the mapping through fork, so the name is not needed anymore and nothing leaks on a crash
+    shm_unlink(name.c_str());
+    if (memory == MAP_FAILED) {
+        error("mmap failed for " + name);
+        return false;
+    }
+    m_memory = memory;
+
+    // position and halo pages are left untouched here, each worker touches its own first so they land on its node
+    char* base = static_cast<char*>(m_memory);
+    m_header = new (base) Header();
+    pthread_mutexattr_t mutex_attributes;
+    pthread_mutexattr_init(&mutex_attributes);
+    pthread_mutexattr_setpshared(&mutex_attributes, PTHREAD_PROCESS_SHARED);
+#ifdef __linux__
+    // a process killed while holding it would otherwise leave every other one blocked on it forever
+    pthread_mutexattr_setrobust(&mutex_attributes, PTHREAD_MUTEX_ROBUST);
+#endif
+    pthread_mutex_init(&m_header->mutex, &mutex_attributes);
+    pthread_mutexattr_destroy(&mutex_attributes);
+    pthread_condattr_t cond_attributes;
+    pthread_condattr_init(&cond_attributes);
+    pthread_condattr_setpshared(&cond_attributes, PTHREAD_PROCESS_SHARED);
+    pthread_cond_init(&m_header->step_ready, &cond_attributes);
+    pthread_condattr_destroy(&cond_attributes);
+    base += header_size;
+    m_sequence = reinterpret_cast<Counter*>(base);
+    for (size_t i = 0; i < domain_count; ++i) new (m_sequence + i) Counter();
+    base += counters_size;
+    m_done = reinterpret_cast<Counter*>(base);
+    for (size_t i = 0; i < domain_count; ++i) new (m_done + i) Counter();
+    base += counters_size;
+    m_positions = reinterpret_cast<glm::vec3*>(base);
+    base += positions_size;
+    m_halos = reinterpret_cast<glm::vec3*>(base);
+
+    m_coordinator = getpid();
+    for (size_t i = 0; i < domain_count; ++i) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            // the workers already running would wait for their missing neighbours forever
+            error("fork failed for domain " + std::to_string(i));
+            stop_workers();
+            return false;
+        }
+        if (pid == 0) {
+#ifdef __linux__
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+            // the coordinator may have died before the death signal was armed
+            if (getppid() == m_coordinator) run_worker((int)i);
+            _exit(0);
+        }
+        m_domains[i].pid = pid;
+    }
+
+    // wait until every domain has written its rows and published its first halo
+    for (size_t i = 0; i < domain_count; ++i) {
+        if (!wait_for(m_sequence[i].value, 1, [&]() { return !workers_alive(); })) {
+            error("a simulation worker exited during start up");
+            stop_workers();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DistributedCloth::step(float dt, const glm::vec3& wind_dir, const glm::vec3& sphere_prev_center, const glm::vec3& sphere_center,
+                            float sphere_radius) {
+    if (m_failed) return false;
+
+    // parameters are published by the release store of the request and left alone until every domain is done
+    m_header->dt = dt;
+    m_header->wind_dir = wind_dir;
+    m_header->sphere_prev_center = sphere_prev_center;
+    m_header->sphere_center = sphere_center;
+    m_header->sphere_radius = sphere_radius;
+    if (!lock_robust(m_header->mutex)) {
+        pthread_mutex_unlock(&m_header->mutex);
+        error("a simulation worker died holding the step lock");
+        stop_workers();
+        m_failed = true;
+        return false;
+    }
+    m_header->step_request.store(++m_step, std::memory_order_release);
+    pthread_cond_broadcast(&m_header->step_ready);
+    pthread_mutex_unlock(&m_header->mutex);
+
+    for (size_t i = 0; i < m_domains.size(); ++i) {
+        if (!wait_for(m_done[i].value, m_step, [&]() { return !workers_alive(); })) {
+            // the strips around a dead worker can't make progress, stop all of them
+            error("a simulation worker exited");
+            stop_workers();
+            m_failed = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DistributedCloth::workers_alive() {
+    for (auto& domain : m_domains) {
+        if (domain.pid <= 0) continue;
+        pid_t result = waitpid(domain.pid, nullptr, WNOHANG);
+        if (result == domain.pid || (result < 0 && errno == ECHILD)) {
+            domain.pid = 0; // reaped
+            return false;
+        }
+    }
+    return true;
+}
+
+void DistributedCloth::stop_workers() {
+    // a worker that died holding the lock is reaped below like every other one
+    lock_robust(m_header->mutex);
+    m_header->quit.store(true, std::memory_order_release);
+    pthread_cond_broadcast(&m_header->step_ready);
+    pthread_mutex_unlock(&m_header->mutex);
+
+    // workers notice the flag within a few milliseconds, one that doesn't (stopped or stuck) is killed
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    for (auto& domain : m_domains) {
+        if (domain.pid <= 0) continue;
+        while (waitpid(domain.pid, nullptr, WNOHANG) == 0) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                kill(domain.pid, SIGKILL);
+                waitpid(domain.pid, nullptr, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        domain.pid = 0;
+    }
+}
+
+bool DistributedCloth::worker_should_stop() const {
+    // an orphaned worker is reparented, so the parent pid changes when the coordinator is gone
+    return m_header->quit.load(std::memory_order_acquire) || getppid() != m_coordinator;
+}
+
+void DistributedCloth::gather(std::vector<glm::vec3>& out_positions) const {
+    out_positions.assign(m_positions, m_positions + m_width * m_height);
+}
+
+const glm::vec3* DistributedCloth::get_positions() const {
+    return m_positions;
+}
+
+int DistributedCloth::get_width() const { return m_width; }
+int DistributedCloth::get_height() const { return m_height; }
+int DistributedCloth::get_domain_count() const { return (int)m_domains.size(); }
+
+glm::vec3* DistributedCloth::get_halo(int domain_index, unsigned long long publication) const {
+    // per domain two buffers alternating with the publication count, each holding its top and bottom two rows
+    return m_halos + ((size_t)domain_index * 2 + publication % 2) * 4 * m_width;
+}
+
+void DistributedCloth::run_worker(int domain_index) {
+    const Domain domain = m_domains[domain_index];
+    pin_to_numa_node(domain.numa_node);
+
+    const int w = m_width, h = m_height, y0 = domain.y_begin, y1 = domain.y_end;
+    const bool has_above = domain_index > 0, has_below = domain_index < (int)m_domains.size() - 1;
+    auto is_pinned = [&](int x, int y) { return y == 0 && (x < 3 || x >= w - 3); };
+
+    float rest_distance[8];
+    for (int k = 0; k < 8; ++k) {
+        rest_distance[k] = glm::length(glm::vec3(constraint_offsets[k][0] / (float)w, -constraint_offsets[k][1] / (float)h, 0.f));
+    }
+
+    // owned rows and the two halo rows on each side, indexed by row - (y0 - 2)
+    std::vector<glm::vec3*> rows(y1 - y0 + 4, nullptr);
+    for (int y = y0; y < y1; ++y) rows[y - y0 + 2] = m_positions + (size_t)y * w;
+    auto get_row = [&](int y) { return rows[y - y0 + 2]; };
+
+    std::vector<glm::vec3> old_positions((size_t)(y1 - y0) * w), accelerations((size_t)(y1 - y0) * w);
+    for (int y = y0; y < y1; ++y) {
+        for (int x = 0; x < w; ++x) {
+            glm::vec3 position = glm::vec3(1.f * (x / (float)w), -1.f * (y / (float)h), 0.f);
+            // same start as Cloth, whose left pins keep the half width offset they get before being pinned
+            if (y == 0 && x < 3) position.x += 0.5f;
+            m_positions[(size_t)y * w + x] = position;
+            old_positions[(size_t)(y - y0) * w + x] = position;
+        }
+    }
+
+    unsigned long long publication = 0;
+    auto stop = [&]() { return worker_should_stop(); };
+    auto exchange = [&]() {
+        ++publication;
+        glm::vec3* halo = get_halo(domain_index, publication);
+        std::memcpy(halo, get_row(y0), sizeof(glm::vec3) * 2 * w);
+        std::memcpy(halo + 2 * w, get_row(y1 - 2), sizeof(glm::vec3) * 2 * w);
+        m_sequence[domain_index].value.store(publication, std::memory_order_release);
+
+        // a neighbour can be at most one publication ahead, so the buffer for this publication stays valid
+        // until we publish the next one
+        if (has_above) {
+            if (!wait_for(m_sequence[domain_index - 1].value, publication, stop)) return false;
+            glm::vec3* above = get_halo(domain_index - 1, publication);
+            rows[0] = above + 2 * w;
+            rows[1] = above + 3 * w;
+        }
+        if (has_below) {
+            if (!wait_for(m_sequence[domain_index + 1].value, publication, stop)) return false;
+            glm::vec3* below = get_halo(domain_index + 1, publication);
+            rows[y1 - y0 + 2] = below;
+            rows[y1 - y0 + 3] = below + w;
+        }
+        return true;
+    };
+    if (!exchange()) return;
+
+    auto add_wind_force_for_triangle = [&](int ax, int ay, int bx, int by, int cx, int cy, const glm::vec3& direction) {
+        glm::vec3 position1 = get_row(ay)[ax], position2 = get_row(by)[bx], position3 = get_row(cy)[cx];
+        glm::vec3 normal = glm::cross(position2 - position1, position3 - position1);
+        glm::vec3 force = normal * glm::dot(glm::normalize(normal), direction);
+        if (ay >= y0 && ay < y1) accelerations[(size_t)(ay - y0) * w + ax] += force;
+        if (by >= y0 && by < y1) accelerations[(size_t)(by - y0) * w + bx] += force;
+        if (cy >= y0 && cy < y1) accelerations[(size_t)(cy - y0) * w + cx] += force;
+    };
+
+    unsigned long long step = 0;
+    while (true) {
+        // parked between steps, the timeout bounds how long a dead coordinator goes unnoticed
+        unsigned long long request = 0;
+        bool owner_alive = lock_robust(m_header->mutex);
+        while (owner_alive && (request = m_header->step_request.load(std::memory_order_acquire)) <= step && !worker_should_stop()) {
+            timespec deadline{};
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 100 * 1000 * 1000;
+            if (deadline.tv_nsec >= 1000 * 1000 * 1000) {
+                deadline.tv_sec += 1;
+                deadline.tv_nsec -= 1000 * 1000 * 1000;
+            }
+            owner_alive = timed_wait_robust(m_header->step_ready, m_header->mutex, deadline);
+        }
+        pthread_mutex_unlock(&m_header->mutex);
+        if (!owner_alive || request <= step) return;
+        const float dt = m_header->dt, sphere_radius = m_header->sphere_radius;
+        const glm::vec3 wind_dir = m_header->wind_dir, sphere_center = m_header->sphere_center;
+        const glm::vec3 sphere_prev_center = m_header->sphere_prev_center;
+
+        // wind on every triangle touching an owned row, forces only land on owned particles
+        for (int y = glm::max(y0 - 1, 0); y < glm::min(y1, h - 1); ++y) {
+            for (int x = 0; x < w - 1; ++x) {
+                add_wind_force_for_triangle(x + 1, y, x, y, x, y + 1, wind_dir);
+                add_wind_force_for_triangle(x + 1, y + 1, x + 1, y, x, y + 1, wind_dir);
+            }
+        }
+
+        // a constraint crossing a strip boundary is solved by both sides, each moving only its own particle by half of
+        // the correction against the neighbour's halo. they go first so the interior sweep smooths the stale halo out.
+        for (int i = 0; i < constraint_iterations; ++i) {
+            for (int pass = 0; pass < 2; ++pass) {
+                bool crossing = pass == 0;
+                for (int y = crossing ? glm::max(y0 - 2, 0) : y0; y < y1; ++y) {
+                    if (crossing && y >= y0 + 2 && y < y1 - 2) continue; // nothing here reaches a halo row
+                    for (int x = 0; x < w; ++x) {
+                        for (int k = 0; k < 8; ++k) {
+                            int qx = x + constraint_offsets[k][0], qy = y + constraint_offsets[k][1];
+                            if (qx < 0 || qx >= w || qy >= h) continue;
+                            bool p_owned = y >= y0, q_owned = qy >= y0 && qy < y1;
+                            if (crossing ? p_owned == q_owned : !q_owned) continue;
+
+                            glm::vec3& p = get_row(y)[x];
+                            glm::vec3& q = get_row(qy)[qx];
+                            glm::vec3 p_to_q = q - p;
+                            float current_distance = glm::length(p_to_q);
+                            glm::vec3 correction_vec_half = p_to_q * (1.f - rest_distance[k] / current_distance) * 0.5f;
+                            if (p_owned && !is_pinned(x, y)) p += correction_vec_half;
+                            if (q_owned && !is_pinned(qx, qy)) q -= correction_vec_half;
+                        }
+                    }
+                }
+            }
+            if (!exchange()) return;
+        }
+
+        for (int y = y0; y < y1; ++y) {
+            for (int x = 0; x < w; ++x) {
+                size_t idx = (size_t)(y - y0) * w + x;
+                glm::vec3& position = get_row(y)[x];
+                if (!is_pinned(x, y)) {
+                    glm::vec3 acceleration = accelerations[idx] + gravity_dir * dt;
+                    glm::vec3 old_position = position;
+                    position = position + (position - old_positions[idx]) * (1.0f - damping) + acceleration * dt;
+                    old_positions[idx] = old_position;
+                    position += Cloth::sphere_collision_offset(old_position, position, sphere_prev_center, sphere_center, sphere_radius);
+                }
+                accelerations[idx] = glm::vec3(0, 0, 0);
+            }
+        }
+        if (!exchange()) return;
+
+        step = request;
+        m_done[domain_index].value.store(step, std::memory_order_release);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef CLOTH_SIMULATION_DISTRIBUTEDCLOTH_H
+#define CLOTH_SIMULATION_DISTRIBUTEDCLOTH_H
+
+#include <glm/gtc/type_ptr.hpp>
+#include <sys/types.h>
+#include <vector>
+
+// Cloth grid split into horizontal strips, each one simulated by its own worker process.
+// Positions live in a single POSIX shared memory segment, every worker only writes the rows it owns and reads the two
+// rows next to its strip from double buffered halos published by its neighbours. Per-domain sequence counters order
+// the exchanges, so a step takes no locks. The process that constructs it acts as the coordinator.
+// Every wait also watches the other side: workers leave when the coordinator asks them to or dies, the coordinator
+// gives up on a step when a worker died and shuts the remaining ones down.
+class DistributedCloth {
+public:
+  DistributedCloth(int w, int h, int domain_count);
+  ~DistributedCloth();
+
+  bool start();
+  bool step(float dt, const glm::vec3& wind_dir, const glm::vec3& sphere_prev_center, const glm::vec3& sphere_center,
+            float sphere_radius);
+  void gather(std::vector<glm::vec3>& out_positions) const;
+  const glm::vec3* get_positions() const; // the shared grid, row major, only stable between steps
+
+  int get_width() const;
+  int get_height() const;
+  int get_domain_count() const;
+
+private:
+  struct Header;
+  struct Counter;
+  struct Domain {
+    int y_begin, y_end;
+    int numa_node;
+    pid_t pid;
+  };
+
+  bool workers_alive(); // reaps a worker that exited
+  void stop_workers();
+  bool worker_should_stop() const;
+  void run_worker(int domain_index);
+  glm::vec3* get_halo(int domain_index, unsigned long long publication) const;
+
+private:
+  int m_width, m_height;
+  int constraint_iterations = 15;
+  std::vector<Domain> m_domains;
+  unsigned long long m_step = 0;
+  pid_t m_coordinator = 0;
+  bool m_failed = false;
+  void* m_memory = nullptr;
+  size_t m_memory_size = 0;
+  Header* m_header = nullptr;
+  Counter* m_sequence = nullptr, *m_done = nullptr;
+  glm::vec3* m_positions = nullptr, *m_halos = nullptr;
+};
+
+#endif //CLOTH_SIMULATION_DISTRIBUTEDCLOTH_H
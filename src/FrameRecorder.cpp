@@ -0,0 +1,193 @@
+#include "FrameRecorder.h"
+#include "utils.h"
+#include <GL/glew.h>
+#include <zlib.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+  void put_u32(std::vector<uint8_t>& out, uint32_t v) {
+      out.push_back(v >> 24);
+      out.push_back(v >> 16);
+      out.push_back(v >> 8);
+      out.push_back(v);
+  }
+
+  void put_chunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size) {
+      put_u32(out, (uint32_t)size);
+      size_t start = out.size();
+      out.insert(out.end(), type, type + 4);
+      out.insert(out.end(), data, data + size);
+      put_u32(out, (uint32_t)crc32(0, out.data() + start, (uInt)(size + 4)));
+  }
+}
+
+FrameRecorder::FrameRecorder(int width, int height, std::string directory, int worker_count)
+    : m_width{width}, m_height{height}, m_directory{std::move(directory)} {
+    if (!prepare_directory(m_directory))
+        m_failed = true;
+
+    glGenBuffers(ring_size, pbos);
+    for (unsigned int pbo : pbos) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)m_width * m_height * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (worker_count <= 0)
+        worker_count = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    // bounds the memory of frames waiting for a free encoder
+    m_max_queued = (size_t)worker_count * 2;
+    for (int i = 0; i < worker_count; i++)
+        m_workers.emplace_back(&FrameRecorder::worker_loop, this);
+}
+
+bool FrameRecorder::prepare_directory(const std::string& directory) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        error("can't create " + directory + ": " + ec.message());
+        return false;
+    }
+
+    std::string probe = directory + "/.write_test";
+    FILE* file = fopen(probe.c_str(), "wb");
+    if (!file) {
+        error("can't write to " + directory);
+        return false;
+    }
+    fclose(file);
+    std::filesystem::remove(probe, ec);
+    return true;
+}
+
+FrameRecorder::~FrameRecorder() {
+    finish();
+    glDeleteBuffers(ring_size, pbos);
+}
+
+void FrameRecorder::capture() {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[m_captured % ring_size]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_captured++;
+
+    // the oldest frame had ring_size - 1 frames to finish its transfer
+    if (m_captured - m_read_back >= ring_size)
+        read_back_oldest();
+}
+
+void FrameRecorder::finish() {
+    while (m_read_back < m_captured)
+        read_back_oldest();
+    if (m_workers.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_job_ready.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+}
+
+bool FrameRecorder::failed() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failed;
+}
+
+void FrameRecorder::read_back_oldest() {
+    Job job;
+    job.frame = m_read_back;
+    job.pixels.resize((size_t)m_width * m_height * 4);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[m_read_back % ring_size]);
+    void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, job.pixels.size(), GL_MAP_READ_BIT);
+    if (data) {
+        memcpy(job.pixels.data(), data, job.pixels.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        error("frame readback failed");
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_read_back++;
+    if (!data)
+        return;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_job_taken.wait(lock, [this] { return m_jobs.size() < m_max_queued; });
+    m_jobs.push_back(std::move(job));
+    lock.unlock();
+    m_job_ready.notify_one();
+}
+
+void FrameRecorder::worker_loop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_job_ready.wait(lock, [this] { return m_quit || !m_jobs.empty(); });
+            if (m_jobs.empty())
+                return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        m_job_taken.notify_one();
+
+        if (!write_png(job)) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_failed = true;
+        }
+    }
+}
+
+bool FrameRecorder::write_png(const Job& job) const {
+    // RGB rows top row first, each with the "up" filter which suits the mostly flat background
+    const size_t stride = (size_t)m_width * 3 + 1;
+    std::vector<uint8_t> filtered(stride * m_height);
+    for (int y = 0; y < m_height; y++) {
+        const uint8_t* row = job.pixels.data() + (size_t)(m_height - 1 - y) * m_width * 4;
+        const uint8_t* above = y > 0 ? row + (size_t)m_width * 4 : nullptr;
+        uint8_t* out = filtered.data() + y * stride;
+        *out++ = above ? 2 : 0;
+        for (int x = 0; x < m_width; x++) {
+            for (int c = 0; c < 3; c++)
+                *out++ = above ? (uint8_t)(row[x * 4 + c] - above[x * 4 + c]) : row[x * 4 + c];
+        }
+    }
+
+    uLongf compressed_size = compressBound((uLong)filtered.size());
+    std::vector<uint8_t> compressed(compressed_size);
+    if (compress2(compressed.data(), &compressed_size, filtered.data(), (uLong)filtered.size(), Z_BEST_SPEED) != Z_OK) {
+        error("png compression failed");
+        return false;
+    }
+
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<uint8_t> header;
+    put_u32(header, m_width);
+    put_u32(header, m_height);
+    header.insert(header.end(), {8, 2, 0, 0, 0}); // 8 bit, RGB, deflate, adaptive filtering, no interlace
+    put_chunk(png, "IHDR", header.data(), header.size());
+    put_chunk(png, "IDAT", compressed.data(), compressed_size);
+    put_chunk(png, "IEND", nullptr, 0);
+
+    char name[32];
+    snprintf(name, sizeof(name), "frame_%05d.png", job.frame);
+    std::string path = (std::filesystem::path(m_directory) / name).string();
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        error("can't write " + path);
+        return false;
+    }
+    bool written = fwrite(png.data(), 1, png.size(), file) == png.size();
+    written = fclose(file) == 0 && written;
+    if (!written)
+        error("can't write " + path);
+    return written;
+}
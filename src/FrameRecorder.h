@@ -0,0 +1,52 @@
+#ifndef CLOTH_SIMULATION_FRAMERECORDER_H
+#define CLOTH_SIMULATION_FRAMERECORDER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes the rendered frames to <directory>/frame_00000.png, ...
+// Readback goes through a ring of pixel buffer objects, so a frame is only mapped a few frames after
+// its glReadPixels was queued and the copy overlaps rendering. PNG encoding runs on worker threads.
+class FrameRecorder {
+public:
+  FrameRecorder(int width, int height, std::string directory, int worker_count);
+  ~FrameRecorder();
+
+  void capture(); // queue readback of the current read framebuffer
+  void finish();  // read back the frames still in flight and wait for every file to be written
+  bool failed() const;
+
+  // creates the directory and checks a file can be written there, so a bad path fails before any rendering
+  static bool prepare_directory(const std::string& directory);
+
+private:
+  struct Job {
+    int frame;
+    std::vector<uint8_t> pixels; // RGBA, bottom row first
+  };
+
+  void read_back_oldest();
+  void worker_loop();
+  bool write_png(const Job& job) const;
+
+private:
+  static constexpr int ring_size = 3;
+  int m_width, m_height;
+  std::string m_directory;
+  unsigned int pbos[ring_size] = {};
+  int m_captured = 0, m_read_back = 0;
+
+  size_t m_max_queued;
+  std::vector<std::thread> m_workers;
+  std::deque<Job> m_jobs;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_job_ready, m_job_taken;
+  bool m_quit = false, m_failed = false;
+};
+
+#endif //CLOTH_SIMULATION_FRAMERECORDER_H
@@ -0,0 +1,157 @@
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "GlyphAtlas.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+
+GlyphAtlas::~GlyphAtlas() {
+    glDeleteTextures(1, &texture);
+}
+
+bool GlyphAtlas::load_font(const std::string& path, int pixel_height) {
+    std::string source;
+    if (!read_file(path, source))
+        return false;
+    m_font_data.assign(source.begin(), source.end());
+
+    // font collections (.ttc) use their first face
+    int offset = stbtt_GetFontOffsetForIndex(m_font_data.data(), 0);
+    if (offset < 0 || !stbtt_InitFont(&m_font, m_font_data.data(), offset)) {
+        error("can't parse font " + path);
+        return false;
+    }
+    m_scale = stbtt_ScaleForPixelHeight(&m_font, (float)pixel_height);
+
+    int ascender, descender, line_gap;
+    stbtt_GetFontVMetrics(&m_font, &ascender, &descender, &line_gap);
+    m_font_info.pixel_height = pixel_height;
+    m_font_info.ascender = (int)std::lround(ascender * m_scale);
+    m_font_info.descender = (int)std::lround(descender * m_scale);
+    m_font_info.line_gap = (int)std::lround(line_gap * m_scale);
+
+    m_glyphs.clear();
+    m_shelves.clear();
+    m_next_shelf_y = 0;
+    m_atlas.clear(256, 64, 0);
+    m_dirty_min_y = 0;
+    m_dirty_max_y = m_atlas.height - 1;
+    return true;
+}
+
+const glyph_info* GlyphAtlas::get_glyph(uint32_t codepoint) {
+    auto it = m_glyphs.find(codepoint);
+    if (it != m_glyphs.end())
+        return &it->second;
+
+    glyph_info glyph;
+    int advance, left_side_bearing, x0, y0, x1, y1;
+    stbtt_GetCodepointHMetrics(&m_font, codepoint, &advance, &left_side_bearing);
+    stbtt_GetCodepointBitmapBox(&m_font, codepoint, m_scale, m_scale, &x0, &y0, &x1, &y1);
+    glyph.size = {x1 - x0, y1 - y0};
+    glyph.bearing = {x0, -y0}; // y0 is the top edge, negative above the baseline
+    glyph.advance = (int)std::lround(advance * m_scale);
+    glyph.ascender = m_font_info.ascender;
+    glyph.descender = m_font_info.descender;
+    glyph.line_gap = m_font_info.line_gap;
+
+    if (glyph.size.x > 0 && glyph.size.y > 0) {
+        int x, y;
+        if (!pack(glyph.size.x + padding, glyph.size.y + padding, x, y)) {
+            error("glyph atlas is full");
+            glyph.size = {0, 0};
+        } else {
+            // stb writes rows top first, which is also how the bitmap stores them
+            glyph.bitmap.clear(glyph.size.x, glyph.size.y, 0);
+            stbtt_MakeCodepointBitmap(&m_font, glyph.bitmap.data.data(), glyph.size.x, glyph.size.y, glyph.size.x, m_scale, m_scale, codepoint);
+            m_atlas.replace_part(glyph.bitmap, x, y);
+            glyph.atlas_position = {x, y};
+            glyph.bitmap = Bitmap<unsigned char>(); // the atlas keeps the pixels
+            m_dirty_min_y = std::min(m_dirty_min_y, y);
+            m_dirty_max_y = std::max(m_dirty_max_y, y + glyph.size.y - 1);
+        }
+    }
+    return &m_glyphs.emplace(codepoint, std::move(glyph)).first->second;
+}
+
+float GlyphAtlas::get_kerning(uint32_t left, uint32_t right) const {
+    return stbtt_GetCodepointKernAdvance(&m_font, left, right) * m_scale;
+}
+
+const font_info& GlyphAtlas::get_font_info() const {
+    return m_font_info;
+}
+
+bool GlyphAtlas::pack(int w, int h, int& out_x, int& out_y) {
+    if (w > m_atlas.width)
+        return false;
+
+    // best fit: the lowest shelf that still has room
+    Shelf* best = nullptr;
+    for (auto& shelf : m_shelves) {
+        if (shelf.height >= h && shelf.x + w <= m_atlas.width && (!best || shelf.height < best->height))
+            best = &shelf;
+    }
+    if (!best) {
+        while (m_next_shelf_y + h > m_atlas.height) {
+            if (m_atlas.height * 2 > max_height)
+                return false;
+            grow();
+        }
+        m_shelves.push_back({m_next_shelf_y, h, 0});
+        m_next_shelf_y += h;
+        best = &m_shelves.back();
+    }
+
+    out_x = best->x;
+    out_y = best->y;
+    best->x += w;
+    return true;
+}
+
+void GlyphAtlas::grow() {
+    // rows are addressed from the bottom, so packed glyphs keep their coordinates
+    Bitmap<unsigned char> larger(m_atlas.width, m_atlas.height * 2, 0);
+    larger.replace_part(m_atlas, 0, 0);
+    m_atlas = larger;
+}
+
+void GlyphAtlas::upload() {
+    if (!texture) {
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (m_texture_height != m_atlas.height) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, m_atlas.width, m_atlas.height, 0, GL_RED, GL_UNSIGNED_BYTE, m_atlas.data.data());
+        m_texture_height = m_atlas.height;
+    } else if (m_dirty_max_y >= m_dirty_min_y) {
+        // texture row r is bitmap data row r, which is row height - 1 - r counted from the bottom
+        int first_row = m_atlas.height - 1 - m_dirty_max_y;
+        int row_count = m_dirty_max_y - m_dirty_min_y + 1;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first_row, m_atlas.width, row_count, GL_RED, GL_UNSIGNED_BYTE,
+                        &m_atlas.data[(size_t)first_row * m_atlas.width]);
+    }
+    m_dirty_min_y = m_atlas.height;
+    m_dirty_max_y = -1;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+unsigned int GlyphAtlas::get_texture() const {
+    return texture;
+}
+
+int GlyphAtlas::get_width() const {
+    return m_atlas.width;
+}
+
+int GlyphAtlas::get_height() const {
+    return m_atlas.height;
+}
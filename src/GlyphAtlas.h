@@ -0,0 +1,53 @@
+#ifndef CLOTH_SIMULATION_GLYPHATLAS_H
+#define CLOTH_SIMULATION_GLYPHATLAS_H
+
+#include "utils.h"
+#include <stb_truetype.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Single channel texture of rasterized glyphs. Glyphs are rasterized the first time they are asked for and
+// packed onto shelves (rows as tall as their tallest glyph), the atlas doubles its height when it is full.
+// Only the rows changed since the last upload are sent to the GPU.
+class GlyphAtlas {
+public:
+  GlyphAtlas() = default;
+  ~GlyphAtlas();
+
+  bool load_font(const std::string& path, int pixel_height);
+  const glyph_info* get_glyph(uint32_t codepoint);
+  float get_kerning(uint32_t left, uint32_t right) const;
+  const font_info& get_font_info() const;
+
+  void upload();
+  unsigned int get_texture() const;
+  int get_width() const;
+  int get_height() const;
+
+private:
+  bool pack(int w, int h, int& out_x, int& out_y);
+  void grow();
+
+private:
+  struct Shelf {
+    int y, height, x; // x is where the next glyph goes
+  };
+  static constexpr int padding = 1; // keeps bilinear filtering from bleeding between neighbours
+  static constexpr int max_height = 4096;
+
+  std::vector<unsigned char> m_font_data;
+  stbtt_fontinfo m_font{};
+  float m_scale = 0.f;
+  font_info m_font_info{};
+  std::unordered_map<uint32_t, glyph_info> m_glyphs;
+
+  Bitmap<unsigned char> m_atlas;
+  std::vector<Shelf> m_shelves;
+  int m_next_shelf_y = 0;
+  int m_dirty_min_y = 0, m_dirty_max_y = -1; // bitmap rows (from the bottom) changed since the last upload
+  unsigned int texture = 0;
+  int m_texture_height = 0;
+};
+
+#endif //CLOTH_SIMULATION_GLYPHATLAS_H
@@ -0,0 +1,249 @@
+#include "Mesh.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace {
+  constexpr int vertex_cache_size = 32;
+
+  unsigned int edge_midpoint(unsigned int p1, unsigned int p2, std::vector<glm::vec3>& positions,
+                             std::unordered_map<uint64_t, unsigned int>& midpoints) {
+      uint64_t key = (uint64_t)std::min(p1, p2) << 32 | std::max(p1, p2);
+      auto it = midpoints.find(key);
+      if (it != midpoints.end())
+          return it->second;
+
+      positions.push_back(glm::normalize((positions[p1] + positions[p2]) / 2.f));
+      unsigned int index = positions.size() - 1;
+      midpoints.emplace(key, index);
+      return index;
+  }
+
+  // weights from the paper, recently used vertices and vertices with few triangles left score higher
+  float vertex_score(int cache_position, int remaining_triangles) {
+      if (remaining_triangles == 0)
+          return -1.f;
+
+      float score = 0.f;
+      if (cache_position >= 0) {
+          if (cache_position < 3) {
+              // the last triangle's vertices, scored lower so the strip doesn't turn back on itself
+              score = 0.75f;
+          } else {
+              float scaler = 1.f / (vertex_cache_size - 3);
+              score = std::pow(1.f - (cache_position - 3) * scaler, 1.5f);
+          }
+      }
+      return score + 2.f / std::sqrt((float)remaining_triangles);
+  }
+}
+
+Mesh generate_ico_sphere(unsigned int subdivisions) {
+    float t = (1.f + glm::sqrt(5.f)) / 2.f;
+    Mesh mesh;
+    mesh.positions = {
+            glm::normalize(glm::vec3(-1.f, t, 0.f)), glm::normalize(glm::vec3(1.f, t, 0.f)),
+            glm::normalize(glm::vec3(-1.f, -t, 0.f)), glm::normalize(glm::vec3(1.f, -t, 0.f)),
+            glm::normalize(glm::vec3(0.f, -1.f, t)), glm::normalize(glm::vec3(0.f, 1.f, t)),
+            glm::normalize(glm::vec3(0.f, -1.f, -t)), glm::normalize(glm::vec3(0.f, 1.f, -t)),
+            glm::normalize(glm::vec3(t, 0.f, -1.f)), glm::normalize(glm::vec3(t, 0.f, 1.f)),
+            glm::normalize(glm::vec3(-t, 0.f, -1.f)), glm::normalize(glm::vec3(-t, 0.f, 1.f))
+    };
+
+    mesh.indices = {
+            0, 11, 5, 0, 5,  1,  0,  1,  7,  0,  7, 10, 0, 10, 11,
+            1, 5,  9, 5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1,  8,
+            3, 9,  4, 3, 4,  2,  3,  2,  6,  3,  6, 8,  3, 8,  9,
+            4, 9,  5, 2, 4,  11, 6,  2,  10, 8,  6, 7,  9, 8,  1
+    };
+
+    std::vector<glm::vec3>& positions = mesh.positions;
+    std::vector<unsigned int>& indices = mesh.indices;
+    for (unsigned int i = 0; i < subdivisions; i++) {
+        // every level adds one vertex per edge, E = 3F / 2
+        std::unordered_map<uint64_t, unsigned int> midpoints;
+        midpoints.reserve(indices.size() / 2);
+        positions.reserve(positions.size() + indices.size() / 2);
+
+        std::vector<unsigned int> indices2;
+        indices2.reserve(indices.size() * 4);
+        for (unsigned int j = 0; j < indices.size() / 3; j++) {
+            unsigned int a = edge_midpoint(indices[j * 3 + 0], indices[j * 3 + 1], positions, midpoints);
+            unsigned int b = edge_midpoint(indices[j * 3 + 1], indices[j * 3 + 2], positions, midpoints);
+            unsigned int c = edge_midpoint(indices[j * 3 + 2], indices[j * 3 + 0], positions, midpoints);
+
+            indices2.insert(indices2.end(), {indices[j * 3 + 0], a, c});
+            indices2.insert(indices2.end(), {indices[j * 3 + 1], b, a});
+            indices2.insert(indices2.end(), {indices[j * 3 + 2], c, b});
+            indices2.insert(indices2.end(), {a, b, c});
+        }
+        indices = std::move(indices2);
+    }
+
+    // unit sphere, the normal is the position
+    mesh.normals = positions;
+    return mesh;
+}
+
+Mesh generate_uv_sphere(float radius, int slices, int stacks) {
+    slices = std::max(slices, 3);
+    stacks = std::max(stacks, 2);
+    Mesh mesh;
+    mesh.positions.reserve(2 + (stacks - 1) * slices);
+
+    // north pole, the rings in between, south pole
+    mesh.normals.emplace_back(0.f, 1.f, 0.f);
+    for (int stack = 1; stack < stacks; stack++) {
+        float theta = glm::pi<float>() * stack / stacks;
+        for (int slice = 0; slice < slices; slice++) {
+            float phi = 2.f * glm::pi<float>() * slice / slices;
+            mesh.normals.emplace_back(std::sin(theta) * std::sin(phi), std::cos(theta), std::sin(theta) * std::cos(phi));
+        }
+    }
+    mesh.normals.emplace_back(0.f, -1.f, 0.f);
+    for (const auto& n : mesh.normals)
+        mesh.positions.push_back(n * radius);
+
+    auto ring_vertex = [slices](int ring, int slice) { return (unsigned int)(1 + ring * slices + slice % slices); };
+    const unsigned int south = mesh.positions.size() - 1;
+    mesh.indices.reserve(slices * (stacks - 1) * 6);
+    for (int slice = 0; slice < slices; slice++) {
+        mesh.indices.insert(mesh.indices.end(), {0, ring_vertex(0, slice), ring_vertex(0, slice + 1)});
+    }
+    for (int ring = 0; ring < stacks - 2; ring++) {
+        for (int slice = 0; slice < slices; slice++) {
+            unsigned int a = ring_vertex(ring, slice), b = ring_vertex(ring, slice + 1);
+            unsigned int c = ring_vertex(ring + 1, slice), d = ring_vertex(ring + 1, slice + 1);
+            mesh.indices.insert(mesh.indices.end(), {a, c, d, a, d, b});
+        }
+    }
+    for (int slice = 0; slice < slices; slice++) {
+        mesh.indices.insert(mesh.indices.end(), {south, ring_vertex(stacks - 2, slice + 1), ring_vertex(stacks - 2, slice)});
+    }
+    return mesh;
+}
+
+void optimize_vertex_cache(std::vector<unsigned int>& indices, size_t vertex_count) {
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+        return;
+
+    // per vertex, its not yet emitted triangles are adjacency[offsets[v], offsets[v] + remaining[v])
+    std::vector<int> remaining(vertex_count, 0), offsets(vertex_count + 1, 0), adjacency(indices.size());
+    for (unsigned int v : indices)
+        remaining[v]++;
+    for (size_t v = 0; v < vertex_count; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++)
+        adjacency[cursor[indices[i]]++] = (int)(i / 3);
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> score(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++)
+        score[v] = vertex_score(-1, remaining[v]);
+
+    std::vector<char> emitted(triangle_count, 0);
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    std::vector<unsigned int> cache, new_cache;
+    cache.reserve(vertex_cache_size + 3);
+    new_cache.reserve(vertex_cache_size + 3);
+
+    int best = -1;
+    size_t next_unemitted = 0;
+    for (size_t emitted_count = 0; emitted_count < triangle_count; emitted_count++) {
+        if (best < 0) {
+            // nothing left around the cache, continue with the next triangle in the original order
+            while (emitted[next_unemitted]) next_unemitted++;
+            best = (int)next_unemitted;
+        }
+
+        const unsigned int* triangle = &indices[best * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[best] = 1;
+        for (int corner = 0; corner < 3; corner++) {
+            unsigned int v = triangle[corner];
+            int* first = &adjacency[offsets[v]];
+            int* last = first + remaining[v] - 1;
+            std::iter_swap(std::find(first, last + 1, best), last);
+            remaining[v]--;
+        }
+
+        // the triangle's vertices move to the front of the LRU cache
+        new_cache.clear();
+        for (int corner = 0; corner < 3; corner++) {
+            if (std::find(new_cache.begin(), new_cache.end(), triangle[corner]) == new_cache.end())
+                new_cache.push_back(triangle[corner]);
+        }
+        for (unsigned int v : cache) {
+            if (std::find(new_cache.begin(), new_cache.end(), v) == new_cache.end())
+                new_cache.push_back(v);
+        }
+
+        for (size_t i = 0; i < new_cache.size(); i++) {
+            unsigned int v = new_cache[i];
+            cache_position[v] = i < vertex_cache_size ? (int)i : -1;
+            score[v] = vertex_score(cache_position[v], remaining[v]);
+        }
+        new_cache.resize(std::min<size_t>(new_cache.size(), vertex_cache_size));
+        std::swap(cache, new_cache);
+
+        // the next triangle is the best one touching the cache
+        best = -1;
+        float best_score = -1.f;
+        for (unsigned int v : cache) {
+            for (int k = offsets[v]; k < offsets[v] + remaining[v]; k++) {
+                int t = adjacency[k];
+                float triangle_score = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                if (triangle_score > best_score) {
+                    best_score = triangle_score;
+                    best = t;
+                }
+            }
+        }
+    }
+    indices = std::move(output);
+}
+
+void optimize_vertex_fetch(Mesh& mesh) {
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(mesh.positions.size(), unused);
+    std::vector<glm::vec3> positions, normals;
+    positions.reserve(mesh.positions.size());
+    normals.reserve(mesh.normals.size());
+    for (unsigned int& index : mesh.indices) {
+        if (remap[index] == unused) {
+            remap[index] = positions.size();
+            positions.push_back(mesh.positions[index]);
+            normals.push_back(mesh.normals[index]);
+        }
+        index = remap[index];
+    }
+    mesh.positions = std::move(positions);
+    mesh.normals = std::move(normals);
+}
+
+const Mesh& MeshCache::get_ico_sphere(unsigned int subdivisions) {
+    Key key{Shape::IcoSphere, 1.f, (int)subdivisions, 0};
+    auto it = m_meshes.find(key);
+    if (it != m_meshes.end())
+        return it->second;
+    return insert(key, generate_ico_sphere(subdivisions));
+}
+
+const Mesh& MeshCache::get_uv_sphere(float radius, int slices, int stacks) {
+    Key key{Shape::UvSphere, radius, slices, stacks};
+    auto it = m_meshes.find(key);
+    if (it != m_meshes.end())
+        return it->second;
+    return insert(key, generate_uv_sphere(radius, slices, stacks));
+}
+
+const Mesh& MeshCache::insert(const Key& key, Mesh mesh) {
+    optimize_vertex_cache(mesh.indices, mesh.positions.size());
+    optimize_vertex_fetch(mesh);
+    return m_meshes.emplace(key, std::move(mesh)).first->second;
+}
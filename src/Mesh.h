@@ -0,0 +1,41 @@
+#ifndef CLOTH_SIMULATION_MESH_H
+#define CLOTH_SIMULATION_MESH_H
+
+#include <glm/gtc/type_ptr.hpp>
+#include <map>
+#include <tuple>
+#include <vector>
+
+// indexed triangle list
+struct Mesh {
+  std::vector<glm::vec3> positions, normals;
+  std::vector<unsigned int> indices;
+};
+
+// unit sphere, every edge midpoint is created once and shared by both triangles of the edge
+Mesh generate_ico_sphere(unsigned int subdivisions);
+// slices around the y axis, stacks from pole to pole, the poles and the seam share their vertices
+Mesh generate_uv_sphere(float radius, int slices, int stacks);
+
+// reorders triangles for the post-transform vertex cache (Forsyth, "Linear-Speed Vertex Cache Optimisation")
+void optimize_vertex_cache(std::vector<unsigned int>& indices, size_t vertex_count);
+// renumbers vertices in the order the indices first use them, so vertex fetch walks memory forward
+void optimize_vertex_fetch(Mesh& mesh);
+
+// Generated and optimized meshes keyed by their parameters, each one is built once and then shared.
+class MeshCache {
+public:
+  const Mesh& get_ico_sphere(unsigned int subdivisions);
+  const Mesh& get_uv_sphere(float radius, int slices, int stacks);
+
+private:
+  enum class Shape { IcoSphere, UvSphere };
+  using Key = std::tuple<Shape, float, int, int>;
+
+  const Mesh& insert(const Key& key, Mesh mesh);
+
+private:
+  std::map<Key, Mesh> m_meshes;
+};
+
+#endif //CLOTH_SIMULATION_MESH_H
@@ -0,0 +1,112 @@
+#include "OffscreenContext.h"
+#include "utils.h"
+#include <GL/glew.h>
+#ifdef CLOTH_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+OffscreenContext::~OffscreenContext() {
+    destroy();
+}
+
+#ifdef CLOTH_HAS_EGL
+bool OffscreenContext::create(int width, int height) {
+    // surfaceless platform needs no display server, fall back to the default display otherwise
+    EGLDisplay display = EGL_NO_DISPLAY;
+    auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display)
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        error("egl init error");
+        return false;
+    }
+    m_display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        error("egl has no desktop opengl");
+        destroy();
+        return false;
+    }
+    const EGLint config_attributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint config_count = 0;
+    eglChooseConfig(display, config_attributes, &config, 1, &config_count);
+
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    // surfaceless contexts don't need a config (EGL_KHR_no_config_context)
+    EGLContext context = eglCreateContext(display, config_count ? config : (EGLConfig)nullptr, EGL_NO_CONTEXT, context_attributes);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        error("egl context init error");
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        destroy();
+        return false;
+    }
+    m_context = context;
+
+    glewExperimental = GL_TRUE;
+    GLenum glew_result = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLX builds of glew also look for an X display, the core entry points are loaded by then
+    if (glew_result == GLEW_ERROR_NO_GLX_DISPLAY) glew_result = GLEW_OK;
+#endif
+    if (glew_result != GLEW_OK) {
+        error("glew init error");
+        destroy();
+        return false;
+    }
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glGenRenderbuffers(1, &color_rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rbo);
+    glGenRenderbuffers(1, &depth_rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        error("offscreen framebuffer incomplete");
+        destroy();
+        return false;
+    }
+    glViewport(0, 0, width, height);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    return true;
+}
+
+void OffscreenContext::destroy() {
+    if (m_context) {
+        if (fbo) {
+            glDeleteFramebuffers(1, &fbo);
+            glDeleteRenderbuffers(1, &color_rbo);
+            glDeleteRenderbuffers(1, &depth_rbo);
+            fbo = color_rbo = depth_rbo = 0;
+        }
+        eglMakeCurrent((EGLDisplay)m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext((EGLDisplay)m_display, (EGLContext)m_context);
+        m_context = nullptr;
+    }
+    if (m_display) {
+        eglTerminate((EGLDisplay)m_display);
+        m_display = nullptr;
+    }
+}
+#else
+bool OffscreenContext::create(int, int) {
+    error("offscreen rendering needs EGL, rebuild with EGL available");
+    return false;
+}
+
+void OffscreenContext::destroy() {
+}
+#endif
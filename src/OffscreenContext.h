@@ -0,0 +1,20 @@
+#ifndef CLOTH_SIMULATION_OFFSCREENCONTEXT_H
+#define CLOTH_SIMULATION_OFFSCREENCONTEXT_H
+
+// Windowless GL 3.3 core context (EGL surfaceless, e.g. Mesa llvmpipe on a server) rendering into an FBO.
+// Only available when built with EGL (CLOTH_HAS_EGL), create() fails otherwise.
+class OffscreenContext {
+public:
+  OffscreenContext() = default;
+  ~OffscreenContext();
+
+  bool create(int width, int height);
+  void destroy();
+
+private:
+  void* m_display = nullptr;
+  void* m_context = nullptr;
+  unsigned int fbo = 0, color_rbo = 0, depth_rbo = 0;
+};
+
+#endif //CLOTH_SIMULATION_OFFSCREENCONTEXT_H
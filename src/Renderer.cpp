@@ -0,0 +1,85 @@
+#include "Renderer.h"
+#include <GL/glew.h>
+#include <algorithm>
+
+static_assert(sizeof(PointLightData) == 48, "PointLightData must match the std140 layout");
+static_assert(sizeof(FrameData) == 144 + 48 * NUM_POINT_LIGHTS, "FrameData must match the std140 layout");
+
+Renderer::Renderer(const std::string& shader_cache_directory) : m_shader_cache{shader_cache_directory} {
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, frame_binding, ubo);
+}
+
+Renderer::~Renderer() {
+    glDeleteBuffers(1, &ubo);
+}
+
+bool Renderer::load_program(ShaderProgram& out_program, const std::string& vs_name, const std::string& fs_name) {
+    unsigned int id = m_shader_cache.load_program(vs_name, fs_name);
+    if (!id)
+        return false;
+
+    out_program.id = id;
+    out_program.model = glGetUniformLocation(id, "model");
+    out_program.color = glGetUniformLocation(id, "aFragColor");
+    out_program.position_offset = glGetUniformLocation(id, "positionOffset");
+    out_program.position_scale = glGetUniformLocation(id, "positionScale");
+    out_program.shininess = glGetUniformLocation(id, "material.shininess");
+
+    unsigned int block = glGetUniformBlockIndex(id, "FrameData");
+    if (block != GL_INVALID_INDEX) {
+        glUniformBlockBinding(id, block, frame_binding);
+    }
+    return true;
+}
+
+void Renderer::begin_frame(const FrameData& frame) {
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    m_commands.clear();
+}
+
+void Renderer::submit(const DrawCommand& command) {
+    m_commands.push_back(command);
+}
+
+void Renderer::flush() {
+    // overlays last, then by program, keeping submission order otherwise
+    std::stable_sort(m_commands.begin(), m_commands.end(), [](const DrawCommand& a, const DrawCommand& b) {
+        if (a.overlay != b.overlay) return !a.overlay;
+        return a.program->id < b.program->id;
+    });
+
+    const ShaderProgram* bound = nullptr;
+    bool depth_test = true;
+    glEnable(GL_DEPTH_TEST);
+    for (const auto& command : m_commands) {
+        if (command.overlay == depth_test) {
+            depth_test = !command.overlay;
+            if (depth_test) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+        }
+        const ShaderProgram* program = command.program;
+        if (program != bound) {
+            glUseProgram(program->id);
+            bound = program;
+        }
+        if (program->model >= 0) glUniformMatrix4fv(program->model, 1, GL_FALSE, glm::value_ptr(command.model));
+        if (program->color >= 0) glUniform4fv(program->color, 1, glm::value_ptr(command.color));
+        if (program->position_offset >= 0) glUniform3fv(program->position_offset, 1, glm::value_ptr(command.position_offset));
+        if (program->position_scale >= 0) glUniform3fv(program->position_scale, 1, glm::value_ptr(command.position_scale));
+
+        glBindVertexArray(command.vao);
+        if (command.indexed) {
+            glDrawElements(command.mode, command.count, GL_UNSIGNED_INT, 0);
+        } else {
+            glDrawArrays(command.mode, 0, command.count);
+        }
+    }
+    glBindVertexArray(NULL);
+    glEnable(GL_DEPTH_TEST);
+    m_commands.clear();
+}
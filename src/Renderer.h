@@ -0,0 +1,65 @@
+#ifndef CLOTH_SIMULATION_RENDERER_H
+#define CLOTH_SIMULATION_RENDERER_H
+
+#include "ShaderCache.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <string>
+#include <vector>
+
+#define NUM_POINT_LIGHTS 1
+
+// std140 mirror of the FrameData uniform block declared in the shaders
+struct PointLightData {
+  glm::vec3 position;
+  float padding0;
+  glm::vec3 color;
+  float attenuation;
+  float intensity;
+  float padding1[3];
+};
+
+struct FrameData {
+  glm::mat4 view;
+  glm::mat4 projection;
+  glm::vec4 view_pos;
+  PointLightData point_lights[NUM_POINT_LIGHTS];
+};
+
+// program with its uniform locations resolved once at load, -1 when the program does not use one
+struct ShaderProgram {
+  unsigned int id = 0;
+  int model = -1, color = -1, position_offset = -1, position_scale = -1, shininess = -1;
+};
+
+struct DrawCommand {
+  const ShaderProgram* program = nullptr;
+  unsigned int vao = 0;
+  unsigned int mode = 0; // GL primitive
+  int count = 0;
+  bool indexed = false;
+  bool overlay = false; // drawn after everything else without depth test
+  glm::mat4 model = glm::mat4(1.f);
+  glm::vec4 color = glm::vec4(1.f);
+  glm::vec3 position_offset = glm::vec3(0.f), position_scale = glm::vec3(1.f);
+};
+
+// Per-frame camera and light data go to one uniform buffer shared by every program,
+// draws are queued and issued sorted by program so each program is bound once per frame.
+class Renderer {
+public:
+  explicit Renderer(const std::string& shader_cache_directory);
+  ~Renderer();
+
+  bool load_program(ShaderProgram& out_program, const std::string& vs_name, const std::string& fs_name);
+  void begin_frame(const FrameData& frame);
+  void submit(const DrawCommand& command);
+  void flush();
+
+private:
+  static constexpr unsigned int frame_binding = 0;
+  unsigned int ubo = 0;
+  ShaderCache m_shader_cache;
+  std::vector<DrawCommand> m_commands;
+};
+
+#endif //CLOTH_SIMULATION_RENDERER_H
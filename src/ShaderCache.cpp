@@ -0,0 +1,149 @@
+#include "ShaderCache.h"
+#include "utils.h"
+#include <GL/glew.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+  struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t binary_size;
+    uint32_t driver_size;
+  };
+
+  constexpr char cache_magic[4] = {'C', 'S', 'P', 'B'};
+  constexpr uint32_t cache_version = 1;
+
+  // FNV-1a, the 0 separators keep "ab" + "c" and "a" + "bc" apart
+  uint64_t hash_strings(std::initializer_list<const std::string*> strings) {
+      uint64_t hash = 14695981039346656037ull;
+      for (const std::string* s : strings) {
+          for (unsigned char c : *s) {
+              hash ^= c;
+              hash *= 1099511628211ull;
+          }
+          hash *= 1099511628211ull;
+      }
+      return hash;
+  }
+
+  std::string gl_string(GLenum name) {
+      const char* s = (const char*)glGetString(name);
+      return s ? s : "";
+  }
+}
+
+ShaderCache::ShaderCache(std::string directory) : m_directory{std::move(directory)} {
+    m_driver = gl_string(GL_VENDOR) + '\n' + gl_string(GL_RENDERER) + '\n' + gl_string(GL_VERSION);
+
+    // core since 4.1, some drivers (macOS) expose the entry points but no binary formats
+    int format_count = 0;
+    if (GLEW_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    m_supported = format_count > 0;
+    if (m_supported) {
+        std::error_code ec;
+        std::filesystem::create_directories(m_directory, ec);
+        m_supported = !ec;
+    }
+}
+
+unsigned int ShaderCache::load_program(const std::string& vs_name, const std::string& fs_name) {
+    std::string vs_source, fs_source;
+    if (!read_file(vs_name, vs_source) || !read_file(fs_name, fs_source)) {
+        error("can't read " + vs_name + " or " + fs_name);
+        return 0;
+    }
+    if (!m_supported)
+        return load_shader_from_source(vs_source, fs_source, vs_name, fs_name, false);
+
+    uint64_t key = hash_strings({&vs_source, &fs_source, &m_driver});
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    std::string path = (std::filesystem::path(m_directory) / name).string();
+
+    unsigned int program = load_binary(path, key);
+    if (program)
+        return program;
+
+    program = load_shader_from_source(vs_source, fs_source, vs_name, fs_name, true);
+    if (program)
+        store_binary(path, key, program);
+    return program;
+}
+
+unsigned int ShaderCache::load_binary(const std::string& path, uint64_t key) const {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return 0;
+
+    CacheHeader header{};
+    std::string driver;
+    std::vector<char> binary;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+                 && memcmp(header.magic, cache_magic, sizeof(cache_magic)) == 0
+                 && header.version == cache_version && header.key == key
+                 && header.driver_size == m_driver.size();
+    if (valid) {
+        driver.resize(header.driver_size);
+        binary.resize(header.binary_size);
+        valid = fread(&driver[0], 1, driver.size(), file) == driver.size() && driver == m_driver
+                && fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    fclose(file);
+
+    unsigned int program = 0;
+    if (valid) {
+        program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+        int success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    if (!program) {
+        error("discarding stale shader cache " + path);
+        std::remove(path.c_str());
+    }
+    return program;
+}
+
+void ShaderCache::store_binary(const std::string& path, uint64_t key, unsigned int program) const {
+    int size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0)
+        return;
+    std::vector<char> binary(size);
+    GLenum format = 0;
+    glGetProgramBinary(program, size, &size, &format, binary.data());
+
+    CacheHeader header{};
+    memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = cache_version;
+    header.key = key;
+    header.format = format;
+    header.binary_size = (uint32_t)size;
+    header.driver_size = (uint32_t)m_driver.size();
+
+    // concurrent runs may store the same program, write privately and rename into place
+    std::string temp_path = path + "." + std::to_string(getpid()) + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (!file)
+        return;
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+                   && fwrite(m_driver.data(), 1, m_driver.size(), file) == m_driver.size()
+                   && fwrite(binary.data(), 1, size, file) == (size_t)size;
+    written = fclose(file) == 0 && written;
+    if (!written || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        error("can't write shader cache " + path);
+        std::remove(temp_path.c_str());
+    }
+}
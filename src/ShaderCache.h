@@ -0,0 +1,26 @@
+#ifndef CLOTH_SIMULATION_SHADERCACHE_H
+#define CLOTH_SIMULATION_SHADERCACHE_H
+
+#include <cstdint>
+#include <string>
+
+// Linked program binaries kept on disk (glGetProgramBinary), one file per program named by a hash of
+// both shader sources and the GL vendor/renderer/version strings, so editing a shader or updating
+// the driver misses the cache. A binary the driver rejects is removed and the program is compiled again.
+class ShaderCache {
+public:
+  explicit ShaderCache(std::string directory);
+
+  unsigned int load_program(const std::string& vs_name, const std::string& fs_name);
+
+private:
+  unsigned int load_binary(const std::string& path, uint64_t key) const;
+  void store_binary(const std::string& path, uint64_t key, unsigned int program) const;
+
+private:
+  std::string m_directory;
+  std::string m_driver; // vendor, renderer and version, also checked against the file to rule out hash collisions
+  bool m_supported = false;
+};
+
+#endif //CLOTH_SIMULATION_SHADERCACHE_H
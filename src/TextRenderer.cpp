@@ -0,0 +1,111 @@
+#include "TextRenderer.h"
+#include <GL/glew.h>
+#include <cstddef>
+
+TextRenderer::~TextRenderer() {
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteProgram(text_shader.id);
+}
+
+bool TextRenderer::init(Renderer& renderer) {
+    if (!renderer.load_program(text_shader, "../shaders/text_vs.glsl", "../shaders/text_fs.glsl"))
+        return false;
+    screen_size_location = glGetUniformLocation(text_shader.id, "screenSize");
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, uv));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, color));
+    glBindVertexArray(NULL);
+    return true;
+}
+
+bool TextRenderer::load_font(const std::string& font_path, int pixel_height) {
+    return m_atlas.load_font(font_path, pixel_height);
+}
+
+void TextRenderer::add_text(const std::string& text, float x, float y, const glm::vec4& color) {
+    const font_info& font = m_atlas.get_font_info();
+    float line_height = (float)(font.ascender - font.descender + font.line_gap);
+    float pen_x = x, baseline = y + font.ascender;
+    uint32_t previous = 0;
+
+    // ASCII is all the HUD prints, every byte is a codepoint
+    for (unsigned char c : text) {
+        if (c == '\n') {
+            pen_x = x;
+            baseline += line_height;
+            previous = 0;
+            continue;
+        }
+        const glyph_info* glyph = m_atlas.get_glyph(c);
+        if (previous)
+            pen_x += m_atlas.get_kerning(previous, c);
+        previous = c;
+
+        if (glyph->size.x > 0 && glyph->size.y > 0) {
+            float x0 = pen_x + glyph->bearing.x, y0 = baseline - glyph->bearing.y;
+            float x1 = x0 + glyph->size.x, y1 = y0 + glyph->size.y;
+            // uvs are resolved in draw() against the final atlas size, here they are in atlas pixels
+            float u0 = (float)glyph->atlas_position.x, u1 = u0 + glyph->size.x;
+            float v_top = (float)(glyph->atlas_position.y + glyph->size.y), v_bottom = (float)glyph->atlas_position.y;
+            m_vertices.push_back({glm::vec2(x0, y0), glm::vec2(u0, v_top), color});
+            m_vertices.push_back({glm::vec2(x0, y1), glm::vec2(u0, v_bottom), color});
+            m_vertices.push_back({glm::vec2(x1, y1), glm::vec2(u1, v_bottom), color});
+            m_vertices.push_back({glm::vec2(x0, y0), glm::vec2(u0, v_top), color});
+            m_vertices.push_back({glm::vec2(x1, y1), glm::vec2(u1, v_bottom), color});
+            m_vertices.push_back({glm::vec2(x1, y0), glm::vec2(u1, v_top), color});
+        }
+        pen_x += glyph->advance;
+    }
+}
+
+void TextRenderer::draw(int viewport_width, int viewport_height) {
+    if (m_vertices.empty())
+        return;
+
+    // glyphs added this frame reach the texture here, the atlas may have grown while adding them
+    m_atlas.upload();
+    float width = (float)m_atlas.get_width(), height = (float)m_atlas.get_height();
+    for (auto& v : m_vertices) {
+        // atlas rows count from the bottom, texture rows from the first row of the bitmap (its top)
+        v.uv = glm::vec2(v.uv.x / width, (height - v.uv.y) / height);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    size_t size = m_vertices.size() * sizeof(Vertex);
+    if (size > m_vbo_capacity)
+        m_vbo_capacity = size * 2;
+    // orphans the previous frame's storage instead of waiting for the GPU to finish reading it
+    glBufferData(GL_ARRAY_BUFFER, m_vbo_capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, m_vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    int polygon_mode[2];
+    glGetIntegerv(GL_POLYGON_MODE, polygon_mode);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glUseProgram(text_shader.id);
+    glUniform2f(screen_size_location, (float)viewport_width, (float)viewport_height);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_atlas.get_texture());
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, (int)m_vertices.size());
+    glBindVertexArray(NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glPolygonMode(GL_FRONT_AND_BACK, polygon_mode[0]);
+    m_vertices.clear();
+}
@@ -0,0 +1,36 @@
+#ifndef CLOTH_SIMULATION_TEXTRENDERER_H
+#define CLOTH_SIMULATION_TEXTRENDERER_H
+
+#include "GlyphAtlas.h"
+#include "Renderer.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <string>
+#include <vector>
+
+// Screen space text batched into one vertex buffer, everything added during a frame is a single draw.
+class TextRenderer {
+public:
+  TextRenderer() = default;
+  ~TextRenderer();
+
+  bool init(Renderer& renderer);
+  bool load_font(const std::string& font_path, int pixel_height); // may be retried with another font after a failure
+  // x, y in pixels from the top left corner of the viewport to the top left of the first line
+  void add_text(const std::string& text, float x, float y, const glm::vec4& color);
+  void draw(int viewport_width, int viewport_height);
+
+private:
+  struct Vertex {
+    glm::vec2 position, uv;
+    glm::vec4 color;
+  };
+
+  GlyphAtlas m_atlas;
+  ShaderProgram text_shader;
+  int screen_size_location = -1;
+  unsigned int vao = 0, vbo = 0;
+  size_t m_vbo_capacity = 0;
+  std::vector<Vertex> m_vertices;
+};
+
+#endif //CLOTH_SIMULATION_TEXTRENDERER_H
@@ -0,0 +1,83 @@
+#include "VertexPacking.h"
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+  uint32_t pack_snorm10(float v) {
+      v = glm::clamp(v, -1.f, 1.f);
+      return (uint32_t)(int)std::lround(v * 511.f) & 0x3ffu;
+  }
+}
+
+void pack_positions_unorm16(const glm::vec3* positions, size_t count, const glm::vec3& min, const glm::vec3& max, uint16_t* out) {
+    // flat axes (a cloth at rest has no depth) still need a finite scale
+    glm::vec3 extent = glm::max(max - min, glm::vec3(1e-6f));
+    glm::vec3 scale = glm::vec3(65535.f / extent.x, 65535.f / extent.y, 65535.f / extent.z);
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128 min_x = _mm_set1_ps(min.x), min_y = _mm_set1_ps(min.y), min_z = _mm_set1_ps(min.z);
+    const __m128 scale_x = _mm_set1_ps(scale.x), scale_y = _mm_set1_ps(scale.y), scale_z = _mm_set1_ps(scale.z);
+    const __m128 half = _mm_set1_ps(0.5f), zero = _mm_setzero_ps(), one = _mm_set1_ps(65535.f);
+    // SSE2 only packs with signed saturation, so values are biased into the signed range and flipped back
+    const __m128i bias = _mm_set1_epi32(32768), sign = _mm_set1_epi16((short)0x8000);
+    auto quantize = [&](__m128 v, __m128 v_min, __m128 v_scale) {
+        __m128 q = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(v, v_min), v_scale), half);
+        q = _mm_min_ps(_mm_max_ps(q, zero), one);
+        return _mm_sub_epi32(_mm_cvttps_epi32(q), bias);
+    };
+    for (; i + 4 <= count; i += 4) {
+        const glm::vec3* p = positions + i;
+        __m128i x = quantize(_mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x), min_x, scale_x);
+        __m128i y = quantize(_mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y), min_y, scale_y);
+        __m128i z = quantize(_mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z), min_z, scale_z);
+
+        __m128i xy = _mm_xor_si128(_mm_packs_epi32(x, y), sign);                       // x0..x3 y0..y3
+        __m128i zw = _mm_xor_si128(_mm_packs_epi32(z, _mm_sub_epi32(_mm_setzero_si128(), bias)), sign); // z0..z3 0..0
+        xy = _mm_unpacklo_epi16(xy, _mm_srli_si128(xy, 8));                            // x0 y0 x1 y1 ..
+        zw = _mm_unpacklo_epi16(zw, _mm_srli_si128(zw, 8));                            // z0 0 z1 0 ..
+        _mm_storeu_si128((__m128i*)(out + i * 4), _mm_unpacklo_epi32(xy, zw));
+        _mm_storeu_si128((__m128i*)(out + i * 4 + 8), _mm_unpackhi_epi32(xy, zw));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        glm::vec3 q = glm::clamp((positions[i] - min) * scale + 0.5f, glm::vec3(0.f), glm::vec3(65535.f));
+        out[i * 4 + 0] = (uint16_t)q.x;
+        out[i * 4 + 1] = (uint16_t)q.y;
+        out[i * 4 + 2] = (uint16_t)q.z;
+        out[i * 4 + 3] = 0;
+    }
+}
+
+void pack_normals_snorm10(const glm::vec3* normals, size_t count, uint32_t* out) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128 range = _mm_set1_ps(511.f), tiny = _mm_set1_ps(1e-20f);
+    const __m128i mask = _mm_set1_epi32(0x3ff);
+    for (; i + 4 <= count; i += 4) {
+        const glm::vec3* n = normals + i;
+        __m128 x = _mm_setr_ps(n[0].x, n[1].x, n[2].x, n[3].x);
+        __m128 y = _mm_setr_ps(n[0].y, n[1].y, n[2].y, n[3].y);
+        __m128 z = _mm_setr_ps(n[0].z, n[1].z, n[2].z, n[3].z);
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        __m128 factor = _mm_div_ps(range, _mm_max_ps(length, tiny));
+
+        // cvtps rounds to nearest, the 10 bit fields keep the two's complement low bits
+        __m128i qx = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(x, factor)), mask);
+        __m128i qy = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(y, factor)), mask);
+        __m128i qz = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(z, factor)), mask);
+        __m128i packed = _mm_or_si128(qx, _mm_or_si128(_mm_slli_epi32(qy, 10), _mm_slli_epi32(qz, 20)));
+        _mm_storeu_si128((__m128i*)(out + i), packed);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        float length = glm::length(normals[i]);
+        glm::vec3 n = length > 0.f ? normals[i] / length : glm::vec3(0.f);
+        out[i] = pack_snorm10(n.x) | pack_snorm10(n.y) << 10 | pack_snorm10(n.z) << 20;
+    }
+}
@@ -0,0 +1,15 @@
+#ifndef CLOTH_SIMULATION_VERTEXPACKING_H
+#define CLOTH_SIMULATION_VERTEXPACKING_H
+
+#include <glm/gtc/type_ptr.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// compact vertex attributes for upload, decoded by the vertex fetch (normalized attributes)
+
+// 4 x GL_UNSIGNED_SHORT per position (w is padding), quantized against [min, max]
+void pack_positions_unorm16(const glm::vec3* positions, size_t count, const glm::vec3& min, const glm::vec3& max, uint16_t* out);
+// 1 x GL_INT_2_10_10_10_REV per normal, normals are normalized while packing
+void pack_normals_snorm10(const glm::vec3* normals, size_t count, uint32_t* out);
+
+#endif //CLOTH_SIMULATION_VERTEXPACKING_H
@@ -0,0 +1,204 @@
+#include "WindField.h"
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+  // lattice cells of the noise over one period of the grid, low enough to read as gusts rather than jitter
+  const int noise_period = 4;
+
+  float hash(int x, int y, int z, int seed) {
+      unsigned h = (unsigned)x * 73856093u ^ (unsigned)y * 19349663u ^ (unsigned)z * 83492791u ^ (unsigned)seed * 2654435761u;
+      h ^= h >> 13;
+      h *= 0x5bd1e995u;
+      h ^= h >> 15;
+      return (float)(h & 0xffffffu) / (float)0xffffffu * 2.f - 1.f;
+  }
+
+  int wrap(int i, int period) {
+      i %= period;
+      return i < 0 ? i + period : i;
+  }
+
+  // periodic value noise in [-1, 1], p is in lattice cells
+  float value_noise(const glm::vec3& p, int period, int seed) {
+      float fx = std::floor(p.x), fy = std::floor(p.y), fz = std::floor(p.z);
+      float tx = p.x - fx, ty = p.y - fy, tz = p.z - fz;
+      tx = tx * tx * (3.f - 2.f * tx);
+      ty = ty * ty * (3.f - 2.f * ty);
+      tz = tz * tz * (3.f - 2.f * tz);
+      int x0 = wrap((int)fx, period), y0 = wrap((int)fy, period), z0 = wrap((int)fz, period);
+      int x1 = (x0 + 1) % period, y1 = (y0 + 1) % period, z1 = (z0 + 1) % period;
+
+      float c00 = glm::mix(hash(x0, y0, z0, seed), hash(x1, y0, z0, seed), tx);
+      float c10 = glm::mix(hash(x0, y1, z0, seed), hash(x1, y1, z0, seed), tx);
+      float c01 = glm::mix(hash(x0, y0, z1, seed), hash(x1, y0, z1, seed), tx);
+      float c11 = glm::mix(hash(x0, y1, z1, seed), hash(x1, y1, z1, seed), tx);
+      return glm::mix(glm::mix(c00, c10, ty), glm::mix(c01, c11, ty), tz);
+  }
+
+  float fbm(const glm::vec3& p, int period, int seed) {
+      return value_noise(p, period, seed) * 0.66f + value_noise(p * 2.f, period * 2, seed + 17) * 0.34f;
+  }
+}
+
+WindField::WindField(const glm::vec3& base_direction, float cell_size, int resolution) : m_cell_size{cell_size}, m_base_direction{base_direction} {
+    // power of two so wrapping is a mask, at least one tile
+    m_resolution = tile_size;
+    while (m_resolution < resolution) m_resolution *= 2;
+    m_tiles_per_axis = m_resolution / tile_size;
+    m_tile_count = m_tiles_per_axis * m_tiles_per_axis * m_tiles_per_axis;
+    m_inv_cell_size = 1.f / m_cell_size;
+
+    size_t point_count = (size_t)m_resolution * m_resolution * m_resolution;
+    for (int i = 0; i < 3; ++i) {
+        m_keyframes[i].time = i * m_keyframe_interval;
+        m_keyframes[i].x.resize(point_count);
+        m_keyframes[i].y.resize(point_count);
+        m_keyframes[i].z.resize(point_count);
+    }
+    for (int tile = 0; tile < m_tile_count; ++tile) {
+        build_tile(m_keyframes[m_prev], tile);
+        build_tile(m_keyframes[m_next], tile);
+    }
+    m_current_x = m_keyframes[m_prev].x;
+    m_current_y = m_keyframes[m_prev].y;
+    m_current_z = m_keyframes[m_prev].z;
+}
+
+void WindField::update(float dt) {
+    m_time += dt;
+    const Keyframe& prev = m_keyframes[m_prev];
+
+    // spread the next keyframe over the interval, and finish it before it is needed
+    float progress = glm::clamp((m_time - prev.time) / m_keyframe_interval, 0.f, 1.f);
+    int target = (int)std::ceil(progress * m_tile_count);
+    for (; m_built_tiles < target; ++m_built_tiles) {
+        build_tile(m_keyframes[m_building], m_built_tiles);
+    }
+
+    if (m_time >= m_keyframes[m_next].time) {
+        int old_prev = m_prev;
+        m_prev = m_next;
+        m_next = m_building;
+        m_building = old_prev;
+        m_keyframes[m_building].time = m_keyframes[m_next].time + m_keyframe_interval;
+        m_built_tiles = 0;
+    }
+
+    const Keyframe& a = m_keyframes[m_prev];
+    const Keyframe& b = m_keyframes[m_next];
+    float t = glm::clamp((m_time - a.time) / m_keyframe_interval, 0.f, 1.f);
+    for (size_t i = 0; i < m_current_x.size(); ++i) {
+        m_current_x[i] = a.x[i] + (b.x[i] - a.x[i]) * t;
+        m_current_y[i] = a.y[i] + (b.y[i] - a.y[i]) * t;
+        m_current_z[i] = a.z[i] + (b.z[i] - a.z[i]) * t;
+    }
+}
+
+void WindField::sample(const glm::vec3* positions, glm::vec3* out_winds, size_t count) const {
+    const float strength = glm::length(m_base_direction) * m_turbulence;
+    const int mask = m_resolution - 1;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128 inv_cell_size = _mm_set1_ps(m_inv_cell_size), one = _mm_set1_ps(1.f);
+    alignas(16) int cell[3][4];
+    alignas(16) float corner[3][8][4];
+    for (; i + 4 <= count; i += 4) {
+        const glm::vec3* p = positions + i;
+        __m128 u[3] = {
+            _mm_mul_ps(_mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x), inv_cell_size),
+            _mm_mul_ps(_mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y), inv_cell_size),
+            _mm_mul_ps(_mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z), inv_cell_size)
+        };
+        __m128 t[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            // floor without SSE4.1, truncation rounds negative values up
+            __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(u[axis]));
+            __m128 floored = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, u[axis]), one));
+            t[axis] = _mm_sub_ps(u[axis], floored);
+            _mm_store_si128((__m128i*)cell[axis], _mm_cvttps_epi32(floored));
+        }
+
+        for (int lane = 0; lane < 4; ++lane) {
+            int x0 = cell[0][lane] & mask, y0 = cell[1][lane] & mask, z0 = cell[2][lane] & mask;
+            int x1 = (x0 + 1) & mask, y1 = (y0 + 1) & mask, z1 = (z0 + 1) & mask;
+            const int idx[8] = {
+                get_idx(x0, y0, z0), get_idx(x1, y0, z0), get_idx(x0, y1, z0), get_idx(x1, y1, z0),
+                get_idx(x0, y0, z1), get_idx(x1, y0, z1), get_idx(x0, y1, z1), get_idx(x1, y1, z1)
+            };
+            for (int c = 0; c < 8; ++c) {
+                corner[0][c][lane] = m_current_x[idx[c]];
+                corner[1][c][lane] = m_current_y[idx[c]];
+                corner[2][c][lane] = m_current_z[idx[c]];
+            }
+        }
+
+        alignas(16) float result[3][4];
+        for (int component = 0; component < 3; ++component) {
+            __m128 c[8];
+            for (int k = 0; k < 8; ++k) c[k] = _mm_load_ps(corner[component][k]);
+            // lerp(a, b, t) = a + (b - a) * t along x, then y, then z
+            for (int k = 0; k < 4; ++k) c[k] = _mm_add_ps(c[2 * k], _mm_mul_ps(_mm_sub_ps(c[2 * k + 1], c[2 * k]), t[0]));
+            for (int k = 0; k < 2; ++k) c[k] = _mm_add_ps(c[2 * k], _mm_mul_ps(_mm_sub_ps(c[2 * k + 1], c[2 * k]), t[1]));
+            c[0] = _mm_add_ps(c[0], _mm_mul_ps(_mm_sub_ps(c[1], c[0]), t[2]));
+            _mm_store_ps(result[component], c[0]);
+        }
+        for (int lane = 0; lane < 4; ++lane) {
+            out_winds[i + lane] = m_base_direction + glm::vec3(result[0][lane], result[1][lane], result[2][lane]) * strength;
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        glm::vec3 u = positions[i] * m_inv_cell_size;
+        float fx = std::floor(u.x), fy = std::floor(u.y), fz = std::floor(u.z);
+        float tx = u.x - fx, ty = u.y - fy, tz = u.z - fz;
+        int x0 = (int)fx & mask, y0 = (int)fy & mask, z0 = (int)fz & mask;
+        int x1 = (x0 + 1) & mask, y1 = (y0 + 1) & mask, z1 = (z0 + 1) & mask;
+        const int idx[8] = {
+            get_idx(x0, y0, z0), get_idx(x1, y0, z0), get_idx(x0, y1, z0), get_idx(x1, y1, z0),
+            get_idx(x0, y0, z1), get_idx(x1, y0, z1), get_idx(x0, y1, z1), get_idx(x1, y1, z1)
+        };
+        glm::vec3 c[8];
+        for (int k = 0; k < 8; ++k) c[k] = glm::vec3(m_current_x[idx[k]], m_current_y[idx[k]], m_current_z[idx[k]]);
+        glm::vec3 turbulence = glm::mix(glm::mix(glm::mix(c[0], c[1], tx), glm::mix(c[2], c[3], tx), ty),
+                                        glm::mix(glm::mix(c[4], c[5], tx), glm::mix(c[6], c[7], tx), ty), tz);
+        out_winds[i] = m_base_direction + turbulence * strength;
+    }
+}
+
+void WindField::set_base_direction(const glm::vec3& direction) {
+    m_base_direction = direction;
+}
+
+void WindField::build_tile(Keyframe& keyframe, int tile) const {
+    int tx = tile % m_tiles_per_axis, ty = (tile / m_tiles_per_axis) % m_tiles_per_axis, tz = tile / (m_tiles_per_axis * m_tiles_per_axis);
+    for (int z = tz * tile_size; z < (tz + 1) * tile_size; ++z) {
+        for (int y = ty * tile_size; y < (ty + 1) * tile_size; ++y) {
+            for (int x = tx * tile_size; x < (tx + 1) * tile_size; ++x) {
+                glm::vec3 turbulence = evaluate(glm::vec3((float)x, (float)y, (float)z) * m_cell_size, keyframe.time);
+                int idx = get_idx(x, y, z);
+                keyframe.x[idx] = turbulence.x;
+                keyframe.y[idx] = turbulence.y;
+                keyframe.z[idx] = turbulence.z;
+            }
+        }
+    }
+}
+
+glm::vec3 WindField::evaluate(const glm::vec3& position, float time) const {
+    // frozen turbulence carried along by the mean wind, the field stays periodic because the noise is
+    float period = m_resolution * m_cell_size, length = glm::length(m_base_direction);
+    glm::vec3 drift = length > 0.f ? m_base_direction * (m_gust_speed * time / length) : glm::vec3(0, 0, 0);
+    glm::vec3 p = (position - drift) * (noise_period / period);
+    return glm::vec3(fbm(p, noise_period, 1), fbm(p, noise_period, 2), fbm(p, noise_period, 3));
+}
+
+int WindField::get_idx(int x, int y, int z) const {
+    int tile = ((z / tile_size) * m_tiles_per_axis + y / tile_size) * m_tiles_per_axis + x / tile_size;
+    int local = ((z % tile_size) * tile_size + y % tile_size) * tile_size + x % tile_size;
+    return tile * tile_size * tile_size * tile_size + local;
+}
@@ -0,0 +1,41 @@
+#ifndef CLOTH_SIMULATION_WINDFIELD_H
+#define CLOTH_SIMULATION_WINDFIELD_H
+
+#include <glm/gtc/type_ptr.hpp>
+#include <vector>
+
+// Gusty wind as a periodic 3D vector field on a tiled grid.
+// Turbulence is value noise advected along the base direction. Two keyframes are blended over time while the next
+// keyframe is rebuilt a few tiles per update, so evaluating noise never stalls a frame. Sampling is trilinear.
+class WindField {
+public:
+  WindField(const glm::vec3& base_direction, float cell_size, int resolution = 32);
+
+  void update(float dt);
+  void sample(const glm::vec3* positions, glm::vec3* out_winds, size_t count) const;
+
+  void set_base_direction(const glm::vec3& direction);
+
+private:
+  struct Keyframe {
+    float time;
+    std::vector<float> x, y, z; // structure of arrays in tile order
+  };
+
+  void build_tile(Keyframe& keyframe, int tile) const;
+  glm::vec3 evaluate(const glm::vec3& position, float time) const;
+  int get_idx(int x, int y, int z) const;
+
+private:
+  static constexpr int tile_size = 4;
+  int m_resolution, m_tiles_per_axis, m_tile_count;
+  float m_cell_size, m_inv_cell_size;
+  float m_keyframe_interval = 2.f, m_time = 0.f, m_turbulence = 0.6f, m_gust_speed = 0.4f;
+  glm::vec3 m_base_direction;
+  Keyframe m_keyframes[3]; // previous, next and the one being built
+  int m_prev = 0, m_next = 1, m_building = 2;
+  int m_built_tiles = 0;
+  std::vector<float> m_current_x, m_current_y, m_current_z;
+};
+
+#endif //CLOTH_SIMULATION_WINDFIELD_H
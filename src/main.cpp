@@ -1,7 +1,38 @@
 #include "Application.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
-int main() {
+int main(int argc, char** argv) {
     Application app("test app", 1024, 768);
+    // cloth_simulation [--cloth <width> <height>] [--domains <count>] [--font <path>] [--offscreen <output directory> <frame count>]
+    const char* offscreen_dir = nullptr;
+    int frame_count = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--offscreen") == 0 && i + 2 < argc) {
+            offscreen_dir = argv[i + 1];
+            frame_count = atoi(argv[i + 2]);
+            i += 2;
+        } else if (strcmp(argv[i], "--cloth") == 0 && i + 2 < argc) {
+            app.set_cloth_size(atoi(argv[i + 1]), atoi(argv[i + 2]));
+            i += 2;
+        } else if (strcmp(argv[i], "--domains") == 0 && i + 1 < argc) {
+            app.set_cloth_domain_count(atoi(argv[i + 1]));
+            i += 1;
+        } else if (strcmp(argv[i], "--font") == 0 && i + 1 < argc) {
+            app.set_hud_font(argv[i + 1]);
+            i += 1;
+        } else {
+            fprintf(stderr, "usage: %s [--cloth <width> <height>] [--domains <count>] [--font <path>] [--offscreen <output directory> <frame count>]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (offscreen_dir) {
+        if (!app.initOffscreen(offscreen_dir, frame_count))
+            return -1;
+        return app.loop();
+    }
     if (!app.initApp())
         return -1;
     return app.loop();
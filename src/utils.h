@@ -8,10 +8,10 @@
 #include "Bitmap.h"
 
 bool read_file(const std::string& filepath, std::string& out_source);
-unsigned int load_shader_from_file(const std::string& vs_name, const std::string& fs_name);
-unsigned int subdivide(unsigned int p1, unsigned int p2, std::vector<glm::vec3>& positions);
-std::vector<glm::vec3> generate_uv_sphere(float radius, int latitudes, int longitudes);
-std::tuple<std::vector<glm::vec3>, std::vector<glm::vec3>, std::vector<unsigned int>> generate_ico_sphere(unsigned int subdivisions);
+// Renderer::load_program is the way to load shaders, it goes through the program binary cache.
+// names are only used in error messages, retrievable programs can be saved with glGetProgramBinary
+unsigned int load_shader_from_source(const std::string& vs_source, const std::string& fs_source,
+                                     const std::string& vs_name, const std::string& fs_name, bool retrievable);
 void error(const std::string& message);
 
 template<typename T>
@@ -22,6 +22,7 @@ struct font_vec2 {
 struct glyph_info {
   glyph_info() : bitmap() { }
   font_vec2<int> size, bearing;
+  font_vec2<int> atlas_position{}; // bottom left corner in the glyph atlas
   int advance, ascender, descender, line_gap;
   Bitmap<unsigned char> bitmap;
   std::map<uint32_t, int> kerning;